@@ -106,7 +106,7 @@ void REPL::run()
 }
 
 /*!
- * @note It'll take seconds to generate tables when you first run the program;
+ * @note It'll take a minute or so to generate tables when you first run the program;
  * please be patient. 
  */
 int main(int argc, char *argv[])
@@ -0,0 +1,79 @@
+/*
+ * Benchmark of compressed table bundles: per table of the cached bundle
+ * (built first if needed), the raw and compressed sizes, and the time to
+ * read it raw and to read and decode it compressed.
+ * usage: bundle_bench [bundle=<table dir>/tables.bin]
+ */
+#include "twophase.hh"
+#include "table.hh"
+#include "storage.hh"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <vector>
+
+namespace fs = std::filesystem;
+using clk = std::chrono::steady_clock;
+
+static double seconds_since(clk::time_point t0)
+{
+    return std::chrono::duration<double>(clk::now() - t0).count();
+}
+
+int main(int argc, char *argv[])
+{
+    fs::path path;
+    if(argc > 1) path = argv[1];
+    else {
+        auto t0 = clk::now();
+        TwoPhaseSolver::init();
+        std::printf("tables obtained in %.3f s\n", seconds_since(t0));
+        path = SingletonTM<>::instance().tdir / TableBase::bundle_file;
+    }
+
+    std::vector<std::vector<char>> data;
+    std::vector<TableBundle::Section> secs;
+    {
+        TableBundle raw(path, false);
+        secs = raw.sections();
+        for(auto &s: secs) {
+            data.emplace_back(s.bytes);
+            raw.read(s, data.back().data());
+            s.data = data.back().data();
+        }
+    }
+    auto dir = fs::temp_directory_path() / "cube_bundle_bench";
+    fs::create_directories(dir);
+    auto packed = dir / "tables.bin";
+    auto t0 = clk::now();
+    TableBundle::publish(packed, secs, true);
+    std::printf("compressed %s in %.3f s\n", path.string().c_str(), seconds_since(t0));
+
+    std::printf("  %-24s %12s %12s %7s %10s %10s\n", "table", "raw", "stored", "ratio", "read ms", "decode ms");
+    TableBundle raw(path, false), comp(packed, false);
+    std::map<std::string,uint64_t> stored_of;
+    for(auto &s: comp.sections()) stored_of[s.name] = s.stored;
+    uint64_t total_raw = 0, total_stored = 0;
+    double total_read = 0, total_decode = 0;
+    for(auto &s: secs) {
+        std::vector<char> buf(s.bytes);
+        auto t1 = clk::now();
+        bool ok = raw.read(s, buf.data());
+        double tr = seconds_since(t1);
+        t1 = clk::now();
+        ok = comp.read(s, buf.data()) && ok;
+        double td = seconds_since(t1);
+        uint64_t stored = stored_of[s.name];
+        std::printf("  %-24s %12llu %12llu %7.3f %10.2f %10.2f%s\n", s.name.c_str(),
+                    (unsigned long long)s.bytes, (unsigned long long)stored,
+                    double(stored) / s.bytes, tr * 1e3, td * 1e3, ok ? "" : " (FAILED)");
+        total_raw += s.bytes, total_stored += stored;
+        total_read += tr, total_decode += td;
+    }
+    std::printf("  %-24s %12llu %12llu %7.3f %10.2f %10.2f\n", "total",
+                (unsigned long long)total_raw, (unsigned long long)total_stored,
+                double(total_stored) / total_raw, total_read * 1e3, total_decode * 1e3);
+    fs::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,321 @@
+/*
+ * Benchmark of prunning table layouts: the 2-D prunning tables (slice x
+ * twist/flip of phase 1, edge4 x corner/edge8 of phase 2) are copied into
+ * each layout, and a fixed-bound pruned search (every node within the bound,
+ * as one iteration of the solver's deepening) is run from random roots.
+ * Layouts of (small, large) coords: row-major [small][large]; col-major 
+ * [large][small] (that of TablePrunning); tiles; and "+layer", which also 
+ * renumbers corner/edge8 so that U/D moves stay near (see layer_order).
+ * Per layout it reports ns/node and the cache misses per node:
+ *  - measured by hardware counters (perf_event_open, Linux), if available;
+ *  - simulated: the addresses of table lookups (move and prunning tables)
+ *    are replayed through set-associative LRU caches of the L1d/L2 sizes.
+ * usage: layout_bench [bound1=10] [bound2=13] [roots=20] [simulated L2 KB]
+ */
+#include "table.hh"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <tuple>
+#include <random>
+#include <vector>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using clk = std::chrono::steady_clock;
+
+static double seconds_since(clk::time_point t0)
+{
+    return std::chrono::duration<double>(clk::now() - t0).count();
+}
+
+/* a set-associative cache of 64B lines with LRU replacement */
+class CacheSim
+{
+public:
+    CacheSim(size_t bytes, size_t ways)
+    :ways_(ways), sets_(std::max<size_t>(1, bytes / 64 / ways)), tag_(sets_ * ways, ~0UL), age_(sets_ * ways, 0) {}
+
+    /* access `addr`, return whether it missed */
+    bool access(uintptr_t addr)
+    {
+        uintptr_t line = addr >> 6;
+        size_t set = line % sets_, lru = 0;
+        auto *tag = &tag_[set * ways_];
+        auto *age = &age_[set * ways_];
+        clock_++;
+        for(size_t w = 0; w < ways_; w++) {
+            if(tag[w] == line) return age[w] = clock_, false;
+            if(age[w] < age[lru]) lru = w;
+        }
+        tag[lru] = line, age[lru] = clock_;
+        return true;
+    }
+private:
+    size_t ways_, sets_;
+    std::vector<uintptr_t> tag_;
+    std::vector<uint64_t> age_;
+    uint64_t clock_ = 0;
+};
+
+/* the L1d and L2 of this machine (or common sizes) */
+struct CacheHierarchy
+{
+    CacheSim l1 { cache_param(_SC_LEVEL1_DCACHE_SIZE, 32 << 10), cache_param(_SC_LEVEL1_DCACHE_ASSOC, 8) };
+    CacheSim l2 { l2_bytes ? l2_bytes : cache_param(_SC_LEVEL2_CACHE_SIZE, 1 << 20), 
+                  cache_param(_SC_LEVEL2_CACHE_ASSOC, 16) };
+    static inline size_t l2_bytes = 0;  // override
+    size_t accesses = 0, l1_miss = 0, l2_miss = 0;
+
+    void access(const void *p)
+    {
+        auto a = reinterpret_cast<uintptr_t>(p);
+        accesses++;
+        if(l1.access(a)) l1_miss++, l2_miss += l2.access(a);
+    }
+
+    static size_t cache_param(int name, size_t fallback)
+    {
+        long v = sysconf(name);
+        return v > 0 ? static_cast<size_t>(v) : fallback;
+    }
+};
+
+/* hardware cache miss counters of this thread, if available */
+class MissCounter
+{
+public:
+    MissCounter()
+    {
+#ifdef __linux__
+        const uint64_t l1 = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                          | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        fd_[0] = open(PERF_TYPE_HW_CACHE, l1);
+        fd_[1] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+    }
+    ~MissCounter()
+    {
+#ifdef __linux__
+        for(int fd: fd_) if(fd >= 0) close(fd);
+#endif
+    }
+    bool available() const { return fd_[0] >= 0 && fd_[1] >= 0; }
+
+    /* the (L1d read, last level) misses since the last call */
+    std::array<uint64_t,2> read()
+    {
+        std::array<uint64_t,2> n {};
+#ifdef __linux__
+        for(int i = 0; i < 2; i++) {
+            uint64_t v = 0;
+            if(fd_[i] >= 0 && ::read(fd_[i], &v, sizeof(v)) == sizeof(v)) n[i] = v - last_[i], last_[i] = v;
+        }
+#endif
+        return n;
+    }
+private:
+#ifdef __linux__
+    static int open(uint32_t type, uint64_t config)
+    {
+        perf_event_attr a;
+        std::memset(&a, 0, sizeof(a));
+        a.size = sizeof(a), a.type = type, a.config = config;
+        a.exclude_kernel = a.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &a, 0, -1, -1, 0));
+    }
+#endif
+    int fd_[2] = { -1, -1 };
+    uint64_t last_[2] = {};
+};
+
+/* an index layout of the 2-D table of shape (A,B): tiles of BA x BB */
+template<size_t BA, size_t BB>
+struct Tiled
+{
+    static constexpr size_t size(size_t A, size_t B) { return (A + BA - 1) / BA * BA * ((B + BB - 1) / BB * BB); }
+    static size_t index(size_t a, size_t b, size_t, size_t B)
+    {
+        const size_t tb = (B + BB - 1) / BB;
+        return ((a / BA) * tb + b / BB) * (BA * BB) + (a % BA) * BB + b % BB;
+    }
+};
+/* row-major [a][b] */
+struct RowMajor
+{
+    static constexpr size_t size(size_t A, size_t B) { return A * B; }
+    static size_t index(size_t a, size_t b, size_t, size_t B) { return a * B + b; }
+};
+/* column-major [b][a] */
+struct ColMajor
+{
+    static constexpr size_t size(size_t A, size_t B) { return A * B; }
+    static size_t index(size_t a, size_t b, size_t A, size_t) { return b * A + a; }
+};
+
+/* the table `t` copied into layout L */
+template<typename L>
+struct Laid
+{
+    /* entry (a,b) of table t[b][a] of TablePrunning (inv: the inverse
+     * renumbering of b) */
+    template<typename Table>
+    Laid(const Table &t, const std::vector<uint32_t> &inv)
+    :A(t.shape[1]), B(t.shape[0]), data(L::size(A, B))
+    {
+        for(size_t a = 0; a < A; a++)
+        for(size_t b = 0; b < B; b++) data[L::index(a, b, A, B)] = t[inv[b]][a];
+    }
+    const uint8_t* at(size_t a, size_t b) const { return &data[L::index(a, b, A, B)]; }
+    size_t A, B;
+    std::vector<uint8_t> data;
+};
+
+using TM_t = TableMove<>;
+using TP_t = TablePrunning<>;
+
+/* a pruned search of one phase: coords (x0,x1,x2) moved by coord-major
+ * tables, bounded by max(P[x0][x1], Q[x0][x2]); `probe` sees every address
+ * looked up */
+template<typename L, size_t NM>
+struct Search
+{
+    const uint16_t *m0, *m1, *m2;   // coord-major move tables of x0,x1,x2
+    const Laid<L> &P, &Q;
+    const std::array<int,NM> &moves;
+
+    template<typename Probe>
+    size_t run(int x0, int x1, int x2, int togo, int last, Probe &&probe) const
+    {
+        const uint8_t *p = P.at(x0, x1), *q = Q.at(x0, x2);
+        probe(p), probe(q);
+        if(std::max<int>(*p, *q) > togo) return 1;
+        size_t n = 1;
+        if(togo == 0) return n;
+        const uint16_t *r0 = m0 + x0 * TM_t::row, *r1 = m1 + x1 * TM_t::row, *r2 = m2 + x2 * TM_t::row;
+        probe(r0), probe(r1), probe(r2);
+        for(auto m: moves) {
+            if(m / 3 == last) continue;     // no successive turns of one face
+            n += run(r0[m], r1[m], r2[m], togo - 1, m / 3, probe);
+        }
+        return n;
+    }
+};
+
+/* a renumbering of the coords of 8-permutations (corner, edge8): the 
+ * position-0..3 (U layer) part least significant, then the 4..7 (D layer)
+ * part, then the set of pieces in the U layer; so that U moves stay within
+ * 24 coords and D moves within 24*24. (ord, inv) */
+static std::pair<std::vector<uint32_t>,std::vector<uint32_t>> layer_order()
+{
+    std::vector<uint32_t> ord(N_CORNER), inv(N_CORNER);
+    for(uint32_t c = 0; c < N_CORNER; c++) {
+        auto p = Perm<8,int>::fromRank(c);
+        std::array<size_t,4> up;    // the pieces in the U layer
+        for(int i = 0; i < 4; i++) up[i] = p[i];
+        std::sort(up.begin(), up.end());
+        // the relative order of pieces in each layer
+        auto rel = [&p](int i0) {
+            Perm<4,int> r;
+            for(int i = 0; i < 4; i++) {
+                r[i] = 0;
+                for(int j = 0; j < 4; j++) r[i] += p[i0 + j] < p[i0 + i];
+            }
+            return r.rank();
+        };
+        // the set of pieces in the U layer is kept by U and D moves
+        size_t set = lexicalOrderFromIndices<8,4>(up);
+        ord[c] = static_cast<uint32_t>((set * 24 + rel(4)) * 24 + rel(0));
+    }
+    std::vector<bool> seen(N_CORNER);
+    for(uint32_t c = 0; c < N_CORNER; c++) {
+        if(ord[c] >= N_CORNER || seen[ord[c]]) throw std::logic_error("layer order is not a bijection");
+        seen[ord[c]] = true, inv[ord[c]] = c;
+    }
+    return { ord, inv };
+}
+
+/* the coord-major move table `t` on coords renumbered by (ord, inv) */
+template<typename Table>
+static std::vector<uint16_t> renumber(const Table &t, const std::vector<uint32_t> &ord, const std::vector<uint32_t> &inv)
+{
+    std::vector<uint16_t> r(t.shape[0] * TM_t::row);
+    for(size_t o = 0; o < t.shape[0]; o++)
+    for(size_t m = 0; m < N_MOVE; m++) r[o * TM_t::row + m] = static_cast<uint16_t>(ord[t[inv[o]][m]]);
+    return r;
+}
+
+/* `ordered`: phase 2 runs on corner and edge8 renumbered by layer_order */
+template<typename L>
+static void bench(const char *name, const TM_t &TM, const TP_t &TP, std::vector<std::array<int,6>> roots, 
+                  int bound1, int bound2, MissCounter &mc, bool ordered = false)
+{
+    static const std::array<int,18> EM0 = { Ux1,Ux2,Ux3,Rx1,Rx2,Rx3,Fx1,Fx2,Fx3,Dx1,Dx2,Dx3,Lx1,Lx2,Lx3,Bx1,Bx2,Bx3 };
+    static const std::array<int,10> EM1 = { Ux1,Ux2,Ux3,Rx2,Fx2,Dx1,Dx2,Dx3,Lx2,Bx2 };
+    std::vector<uint32_t> ord(N_CORNER), inv(N_CORNER);
+    std::iota(ord.begin(), ord.end(), 0), std::iota(inv.begin(), inv.end(), 0);
+    if(ordered) std::tie(ord, inv) = layer_order();
+    auto id1 = std::vector<uint32_t>(N_FLIP * 2);
+    std::iota(id1.begin(), id1.end(), 0);
+    auto mc2 = renumber(*TM.pTMCornerC, ord, inv), me2 = renumber(*TM.pTMEdge8C, ord, inv);
+    for(auto &r: roots) r[4] = ord[r[4]], r[5] = ord[r[5]];
+
+    Laid<L> st(*TP.pTPTwistSlice, id1), sf(*TP.pTPFlipSlice, id1);
+    Laid<L> ec(*TP.pTPCornerEdge4, inv), ee(*TP.pTPEdge8Edge4, inv);
+    Search<L,18> s1 { TM.pTMSliceC->flat(), TM.pTMTwistC->flat(), TM.pTMFlipC->flat(), st, sf, EM0 };
+    Search<L,10> s2 { TM.pTMEdge4C->flat(), mc2.data(), me2.data(), ec, ee, EM1 };
+
+    auto report = [&](const char *phase, auto &&search) {
+        auto none = [](const void*) {};
+        size_t n = 0;
+        mc.read();
+        auto t0 = clk::now();
+        for(auto &r: roots) n += search(r, none);
+        double s = seconds_since(t0);
+        auto hw = mc.read();
+        CacheHierarchy sim;
+        auto probe = [&sim](const void *p) { sim.access(p); };
+        for(auto &r: roots) search(r, probe);
+        std::printf("  %-10s %-8s %11zu nodes %7.2f ns/node", name, phase, n, s * 1e9 / n);
+        if(mc.available())
+            std::printf(" | hw L1d %5.2f LLC %5.3f", double(hw[0]) / n, double(hw[1]) / n);
+        std::printf(" | sim L1d %5.2f L2 %5.3f /node\n", double(sim.l1_miss) / n, double(sim.l2_miss) / n);
+    };
+    report("phase 1", [&](auto &r, auto &&probe) { return s1.run(r[0], r[1], r[2], bound1, -1, probe); });
+    report("phase 2", [&](auto &r, auto &&probe) { return s2.run(r[3], r[4], r[5], bound2, -1, probe); });
+}
+
+int main(int argc, char *argv[])
+{
+    int bound1 = argc > 1 ? std::atoi(argv[1]) : 10;
+    int bound2 = argc > 2 ? std::atoi(argv[2]) : 13;
+    int n_root = argc > 3 ? std::atoi(argv[3]) : 20;
+    if(argc > 4) CacheHierarchy::l2_bytes = std::strtoul(argv[4], nullptr, 10) << 10;
+
+    const auto &TM = SingletonTM<>::instance();
+    const auto &TP = SingletonTP<>::instance();
+    std::mt19937 rng(2024);
+    auto rand = [&rng](int n) { return std::uniform_int_distribution<int>(0, n-1)(rng); };
+    // (slice, twist, flip) and (edge4, corner, edge8)
+    std::vector<std::array<int,6>> roots;
+    for(int i = 0; i < n_root; i++)
+        roots.push_back({ rand(N_SLICE), rand(N_TWIST), rand(N_FLIP), rand(N_EDGE4), rand(N_CORNER), rand(N_EDGE8) });
+
+    MissCounter mc;
+    std::printf("bounds %d / %d, %d roots; hardware counters %savailable\n",
+                bound1, bound2, n_root, mc.available() ? "" : "not ");
+    bench<RowMajor>("row-major", TM, TP, roots, bound1, bound2, mc);
+    bench<ColMajor>("col-major", TM, TP, roots, bound1, bound2, mc);
+    bench<Tiled<2,32>>("tile 2x32", TM, TP, roots, bound1, bound2, mc);
+    bench<Tiled<4,16>>("tile 4x16", TM, TP, roots, bound1, bound2, mc);
+    bench<Tiled<8,8>>("tile 8x8", TM, TP, roots, bound1, bound2, mc);
+    bench<RowMajor>("row+layer", TM, TP, roots, bound1, bound2, mc, true);
+    bench<ColMajor>("col+layer", TM, TP, roots, bound1, bound2, mc, true);
+    return 0;
+}
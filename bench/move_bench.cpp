@@ -0,0 +1,105 @@
+/*
+ * Benchmark of move table layouts: nodes/sec of unpruned depth-first 
+ * expansions through the move-major (t[m][x]) and coord-major (tc[x][m]) 
+ * tables (and the flipslice table with CUBE_TABLE_FLIPSLICE=1), and of the 
+ * twophase solver on random cubes.
+ * usage: move_bench [depth=5] [roots=20] [cubes=5]
+ */
+#include "twophase.hh"
+#include "table.hh"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using clk = std::chrono::steady_clock;
+
+static double seconds_since(clk::time_point t0)
+{
+    return std::chrono::duration<double>(clk::now() - t0).count();
+}
+
+/* expand all nodes within `depth` of (a,b,c), moving each coord by `mv`;
+ * the coords of leaves are summed into `sum` so that no lookup is elided */
+template<typename Moves, typename Move>
+static size_t expand(int a, int b, int c, int depth, const Moves &ms, Move &&mv, size_t &sum)
+{
+    if(depth == 0) return sum += a + b + c, 1;
+    size_t n = 1;
+    for(auto m: ms) {
+        auto [a1,b1,c1] = mv(a,b,c,m);
+        n += expand(a1, b1, c1, depth-1, ms, mv, sum);
+    }
+    return n;
+}
+
+template<typename Moves, typename Move>
+static void bench_layout(const char *name, const std::vector<std::array<int,3>> &roots, 
+                         int depth, const Moves &ms, Move &&mv)
+{
+    size_t n = 0, sum = 0;
+    auto t0 = clk::now();
+    for(auto &r: roots) n += expand(r[0], r[1], r[2], depth, ms, mv, sum);
+    double s = seconds_since(t0);
+    std::printf("  %-14s %12zu nodes %8.3f s %8.2f Mnodes/s (checksum %zx)\n", 
+                name, n, s, n / s / 1e6, sum);
+}
+
+int main(int argc, char *argv[])
+{
+    int depth = argc > 1 ? std::atoi(argv[1]) : 5;
+    int n_root = argc > 2 ? std::atoi(argv[2]) : 20;
+    int n_cube = argc > 3 ? std::atoi(argv[3]) : 5;
+
+    TwoPhaseSolver::init();
+    const auto &TM = SingletonTM<>::instance();
+    std::mt19937 rng(2024);
+    auto rand = [&rng](int n) { return std::uniform_int_distribution<int>(0, n-1)(rng); };
+
+    const std::array<int,18> EM0 = { Ux1,Ux2,Ux3,Rx1,Rx2,Rx3,Fx1,Fx2,Fx3,Dx1,Dx2,Dx3,Lx1,Lx2,Lx3,Bx1,Bx2,Bx3 };
+    const std::array<int,10> EM1 = { Ux1,Ux2,Ux3,Rx2,Fx2,Dx1,Dx2,Dx3,Lx2,Bx2 };
+    using R = std::array<int,3>;
+
+    std::vector<R> roots1, roots2;
+    for(int i = 0; i < n_root; i++) roots1.push_back({ rand(N_TWIST), rand(N_FLIP), rand(N_SLICE) });
+    for(int i = 0; i < n_root; i++) roots2.push_back({ rand(N_CORNER), rand(N_EDGE4), rand(N_EDGE8) });
+
+    std::printf("phase 1 expansion (twist, flip, slice), depth %d:\n", depth);
+    bench_layout("move-major", roots1, depth, EM0, [&TM](int a, int b, int c, int m) {
+        return R{ (*TM.pTMTwist)[m][a], (*TM.pTMFlip)[m][b], (*TM.pTMSlice)[m][c] };
+    });
+    bench_layout("coord-major", roots1, depth, EM0, [&TM](int a, int b, int c, int m) {
+        return R{ (*TM.pTMTwistC)[a][m], (*TM.pTMFlipC)[b][m], (*TM.pTMSliceC)[c][m] };
+    });
+
+    if(TM.pTMFlipSliceC)
+    bench_layout("flipslice", roots1, depth, EM0, [&TM](int a, int b, int c, int m) {
+        auto fs = (*TM.pTMFlipSliceC)[c * N_FLIP + b][m];
+        return R{ (*TM.pTMTwistC)[a][m], int(fs % N_FLIP), int(fs / N_FLIP) };
+    });
+
+    std::printf("phase 2 expansion (corner, edge4, edge8), depth %d:\n", depth + 1);
+    bench_layout("move-major", roots2, depth + 1, EM1, [&TM](int a, int b, int c, int m) {
+        return R{ (*TM.pTMCorner)[m][a], (*TM.pTMEdge4)[m][b], (*TM.pTMEdge8)[m][c] };
+    });
+    bench_layout("coord-major", roots2, depth + 1, EM1, [&TM](int a, int b, int c, int m) {
+        return R{ (*TM.pTMCornerC)[a][m], (*TM.pTMEdge4C)[b][m], (*TM.pTMEdge8C)[c][m] };
+    });
+
+    std::printf("twophase solver, %d random cubes:\n", n_cube);
+    TwoPhaseSolver solver;
+    std::array<size_t,2> nodes {};
+    double s = 0;
+    for(int i = 0; i < n_cube; i++) {
+        std::vector<TurnMove> ms;
+        for(int j = 0; j < 40; j++) ms.push_back(static_cast<TurnMove>(rand(N_MOVE)));
+        auto c = Coord::CubieCube2Coord(CubieCube::id * ms);
+        auto t0 = clk::now();
+        solver.solve(c, 30, false);
+        s += seconds_since(t0);
+        nodes[0] += solver.nodes()[0], nodes[1] += solver.nodes()[1];
+    }
+    std::printf("  %zu + %zu nodes %8.3f s %8.2f Mnodes/s\n", 
+                nodes[0], nodes[1], s, (nodes[0] + nodes[1]) / s / 1e6);
+    return 0;
+}
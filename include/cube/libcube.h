@@ -34,29 +34,170 @@ enum status_code {
     CODE_NOT_FOUND = 2,
     CODE_INVALID_SRC = 3,
     CODE_INVALID_TGT = 4,
-    CODE_UNKNOWN_ERROR = 5
+    CODE_UNKNOWN_ERROR = 5,
+    CODE_NOT_READY = 6
+};
+
+/* the state of solver tables, see `init_solver_async` */
+enum table_state {
+    TABLES_NONE = 0,        /* not requested yet */
+    TABLES_LOADING = 1,     /* being loaded (or built) in background */
+    TABLES_READY = 2,
+    TABLES_FAILED = 3
+};
+
+/* the flags of the `best` argument of `solve_ultimate` */
+enum solve_mode {
+    SOLVE_FIRST = 0,        /* the first solution found */
+    SOLVE_BEST = 1,         /* try its best to find the short (but slower) solution */
+    SOLVE_PARALLEL = 2,     /* search the 3 axes x the inverse cube in parallel */
+    SOLVE_OPTIMAL = 4,      /* the optimal solution (see `solve_optimal`) */
+    SOLVE_SPLIT = 8         /* split the search of the cube among all cores */
+};
+
+/* the tiers of solver tables, trading memory for solving speed (see `solver_tier_info`) */
+enum solver_tier {
+    TIER_MINIMAL = 0,       /* move tables and small prunning tables */
+    TIER_STANDARD = 1,      /* + exact (symmetry-reduced) phase 1 table */
+    TIER_LARGE = 2,         /* + symmetry-reduced phase 2 table */
+    TIER_EXACT = 3          /* + exact phase 2 table (~335MB, ~1.9GB to build) */
 };
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*!
+ * @brief load (or build at the first run) the tables of solver
+ * @details The tables are loaded on the first solve otherwise; loading the 
+ * library itself never touches them.
+ * @return status_code: CODE_OK, or CODE_UNKNOWN_ERROR if tables cannot be created
+ */
+int init_solver(void);
+
+/*!
+ * @brief select the tier of solver tables, before they are loaded
+ * @details The default tier is TIER_STANDARD, or set by CUBE_TABLE_TIER 
+ * (minimal|standard|large|exact). Tables are loaded once per process, so the tier
+ * cannot be changed once `init_solver*` or a solve was called.
+ * @return status_code: CODE_OK, or CODE_UNKNOWN_ERROR if `tier` is invalid 
+ *         or the tables of another tier are loaded
+ */
+int set_solver_tier(int tier);
+
+/* the tier of solver tables: see enum `solver_tier` */
+int get_solver_tier(void);
+
+/*!
+ * @brief set the depth of the endgame table, before the tables are loaded
+ * @details Cubes within `depth` moves of the target are then solved optimally
+ * by walking down the table instead of searching; the table takes ~5MB, 
+ * ~66MB and ~870MB for depth 5, 6 and 7. The default depth is 0 (no table),
+ * or set by CUBE_TABLE_ENDGAME.
+ * @return status_code: CODE_OK, or CODE_UNKNOWN_ERROR if `depth` is not in 
+ *         0..7 or the tables are loaded with another depth
+ */
+int set_solver_endgame(int depth);
+
+/*!
+ * @brief describe the trade-off of `tier`, eg:
+ *      `standard: 50MB; phase 1 exact, phase 2 bounded by edge4 x corner/edge8; ...`
+ * @return the memory footprint of the tables of `tier` in bytes, -1 if invalid
+ */
+long long solver_tier_info(int tier, char *buffer);
+
+/*!
+ * @brief start loading (or building) the tables of solver on a background thread
+ * @details Until the tables are ready, `solve_ultimate` returns CODE_NOT_READY
+ * instead of blocking; poll with `solver_state` or block with `wait_solver`.
+ * Calling it again while loading, or once ready, does nothing.
+ * @return status_code: CODE_OK
+ */
+int init_solver_async(void);
+
+/* the state of solver tables: see enum `table_state` */
+int solver_state(void);
+
+/*!
+ * @brief describe the memory backing the tables of solver obtained, in MB 
+ * (numa: interleaved over the NUMA nodes), eg:
+ *      `tables 98MB: mapped 0, hugetlb 0, thp 64, locked 98, numa 98/2 nodes`
+ * (all zero before the tables are ready); see CUBE_TABLE_PAGES, CUBE_TABLE_NUMA
+ * and CUBE_TABLE_MLOCK in the readme.
+ */
+void solver_backing(char *buffer);
+
+/*!
+ * @brief wait for the tables of solver (started by `init_solver_async`)
+ * @param timeout_ms  the max time to wait in milliseconds; negative => no limit
+ * @return status_code: CODE_OK if ready, CODE_NOT_READY on timeout or if not 
+ *         started, CODE_UNKNOWN_ERROR if tables cannot be created
+ */
+int wait_solver(int timeout_ms);
+
 /*! 
  * @brief solve the Rubic's cube
  * @param src       source color configuration, `NULL` means `id`
  * @param tgt       target color configuration, `NULL` means `id`
  * @param solution  the sequence of moves 
  * @param step      the max steps to search (30 is recommended;)
- * @param best      try its best to find the short (but slower) solution
+ * @param best      try its best to find the short (but slower) solution;
+ *                  or the flags of enum `solve_mode`: with SOLVE_PARALLEL, the 
+ *                  cube is searched along its 3 axes and as its inverse, on up
+ *                  to 6 threads sharing the best length, which mostly gives 
+ *                  shorter solutions at the latency of one search on 6 cores;
+ *                  with SOLVE_SPLIT, the phase 1 search is split into subtrees
+ *                  taken by idle threads and sharing the best length, which
+ *                  lowers the latency of one cube (ignored with SOLVE_PARALLEL);
+ *                  with SOLVE_OPTIMAL, the fewest moves (other flags ignored)
  * @param formated  1 => solution is maneuver formatted (sequence of U..B' separated by space); 
  *                  0 => raw moves (sequennce of char = 1..18 representing move U..B')
- * @return status_code: see enum `status_code`.        
+ * @return status_code: see enum `status_code`; CODE_NOT_READY while the 
+ *         tables are loaded in background (see `init_solver_async`).        
+ * @note The solve functions are reentrant: each call searches with its own
+ *       state over the shared read-only tables, so that calls from several
+ *       threads run concurrently without a lock.
  */
 int solve_ultimate(const char *src, const char* tgt, char* solution_buffer, int step, int best, int formated);
 
 // solve_ultimate(src,NULL,buf,30,best,1)
 int solve(const char *src, char* solution_buffer, int best);
 
+/* called by `solve_anytime` with each shorter solution found (formatted as
+ * its result) and the `user` pointer given */
+typedef void (*solve_callback)(const char *solution, void *user);
+
+/*!
+ * @brief solve the cube within a budget of time and/or nodes (anytime)
+ * @details The search keeps improving the solution (as SOLVE_BEST, but past
+ * the length where SOLVE_BEST stops) until none is shorter or the budget
+ * runs out, then returns the shortest found. The budget is checked every 
+ * 256 nodes (some µs) and does not cover loading the tables, which is done
+ * first (see `init_solver`).
+ * @param deadline_us   the time from the call to stop at, in microseconds (<= 0 => no limit)
+ * @param max_nodes     the max count of search nodes (<= 0 => no limit)
+ * @param improved      (nullable) called with each shorter solution and `user`,
+ *                      on the calling thread; its time counts in the budget
+ * (other params: see `solve_ultimate`)
+ * @return status_code: see `solve_ultimate`; CODE_NOT_FOUND if no solution
+ *         within `step` moves was found within the budget
+ */
+int solve_anytime(const char *src, const char* tgt, char* solution_buffer, int step, 
+                  long long deadline_us, long long max_nodes, int formated, solve_callback improved, void *user);
+
+/*!
+ * @brief solve the cube in the fewest moves (God's algorithm) 
+ * @details IDA* over all moves, bounded by a corner pattern database (~1.5MB,
+ * built on the first call) and the phase 1 tables, split at the root among 
+ * the hardware threads. Cubes up to ~15 moves take seconds; random cubes 
+ * (~18 moves) take from minutes to hours: bound `step` to give up earlier.
+ * @param bound     (nullable) set to the length that every shorter maneuver
+ *                  was exhausted to: the solution length (proving it
+ *                  optimal), or step+1 if CODE_NOT_FOUND
+ * (other params and return: see `solve_ultimate`)
+ */
+int solve_optimal(const char *src, const char* tgt, char* solution_buffer, int step, int formated, int *bound);
+
 /* check the solvability of color configuration ( 0 - unsolvable; 1 - solvable ) */
 int solvable(const char* color_cube);
 
@@ -1,12 +1,89 @@
-from ._lib import _cube_lib, c_solve_ultimate, c_facecube, c_permutation, c_solvable
-from .exceptions import CubeError, StatusCode
+from ._lib import _cube_lib, c_init_solver, c_init_solver_async, c_solver_ready, c_wait_solver, c_solver_backing, c_set_solver_tier, c_get_solver_tier, c_solver_tier_info, c_set_solver_endgame, c_solve_ultimate, c_solve_optimal, c_solve_anytime, c_facecube, c_permutation, c_solvable
+from .exceptions import CubeError, StatusCode, Tier
 
 
-__all__ = [ 'solve','get_facecube','get_permutaion','is_solvable','CubeError' ]
+__all__ = [ 'init','init_async','is_ready','wait_ready','get_backing','set_tier','get_tier','tier_info','Tier','set_endgame','solve','solve_optimal','solve_anytime','get_facecube','get_permutaion','is_solvable','CubeError' ]
 
 cid = 'UUUUUUUUURRRRRRRRRFFFFFFFFFDDDDDDDDDLLLLLLLLLBBBBBBBBB'
 
 
+def init() -> None:
+    """
+    Load the solver tables now (they are loaded on the first solve otherwise);
+    the first run builds and caches them, which takes a while.
+
+    Raise:
+        CubeError(code) if the tables cannot be created
+    """
+    c_init_solver()
+
+
+def init_async() -> None:
+    """
+    Start loading the solver tables on a background thread; until they are 
+    ready, solving raises CubeError(StatusCode.NOT_READY) instead of blocking.
+    """
+    c_init_solver_async()
+
+
+def is_ready() -> bool:
+    """ Whether the tables started by `init_async` are ready """
+    return c_solver_ready()
+
+
+def wait_ready(timeout_ms: int = -1) -> bool:
+    """
+    Wait for the tables started by `init_async` (negative timeout => no limit)
+
+    Return:
+        whether the tables are ready
+
+    Raise:
+        CubeError(code) if the tables cannot be created
+    """
+    rc = c_wait_solver(timeout_ms)
+    if rc == StatusCode.NOT_READY: return False
+    check_status(rc)
+    return True
+
+
+def get_backing() -> str:
+    """ Describe the memory (huge pages, locked, NUMA) backing the solver tables """
+    return c_solver_backing()
+
+
+def set_tier(tier: Tier) -> None:
+    """
+    Select the tier of solver tables (trading memory for speed), before they
+    are loaded; see `tier_info`.
+
+    Raise:
+        CubeError(code) if the tier is invalid or tables of another tier are loaded
+    """
+    c_set_solver_tier(int(tier))
+
+
+def get_tier() -> Tier:
+    """ The tier of solver tables """
+    return Tier(c_get_solver_tier())
+
+
+def tier_info(tier: Tier) -> tuple:
+    """ The memory footprint (bytes) of the tables of `tier`, and its trade-off """
+    return c_solver_tier_info(int(tier))
+
+
+def set_endgame(depth: int) -> None:
+    """
+    Set the depth (0..7) of the endgame table, before the tables are loaded:
+    cubes within `depth` moves are then solved optimally by a lookup walk.
+
+    Raise:
+        CubeError(code) if the depth is invalid or tables of another depth are loaded
+    """
+    c_set_solver_endgame(depth)
+
+
 def solve_ultimate(src: str, tgt: str = cid, step: int = 30, best: bool = False) -> str:
     """
     Solve the cube
@@ -29,6 +106,40 @@ def solve_ultimate(src: str, tgt: str = cid, step: int = 30, best: bool = False)
     return c_solve_ultimate(src_bytes, tgt_bytes, step, best)
 
 
+def solve_optimal(src: str, tgt: str = cid, step: int = 30) -> tuple:
+    """
+    Solve the cube in the fewest moves (slow: minutes or more for random
+    cubes, see `solve_optimal` of libcube)
+
+    Return:
+        (the sequence of moves, its length proved optimal)
+
+    Raise:
+        CubeError(code) as `solve_ultimate`, CODE_NOT_FOUND if none within `step`
+    """
+    if tgt is None: tgt = cid
+    return c_solve_optimal(src.encode('utf-8'), tgt.encode('utf-8'), step)
+
+
+def solve_anytime(src: str, tgt: str = cid, step: int = 30, deadline_us: int = 0, max_nodes: int = 0, 
+                  improved = None) -> str:
+    """
+    Solve the cube, improving the solution until the budget runs out
+    Args:
+        deadline_us : the time to stop at from the call, in microseconds (0 => no limit)
+        max_nodes   : the max count of search nodes (0 => no limit)
+        improved    : (optional) called with each shorter solution found
+
+    Return:
+        the shortest sequence of moves found
+
+    Raise:
+        CubeError(code) as `solve_ultimate`, CODE_NOT_FOUND if none found within the budget
+    """
+    if tgt is None: tgt = cid
+    return c_solve_anytime(src.encode('utf-8'), tgt.encode('utf-8'), step, deadline_us, max_nodes, improved)
+
+
 def solve(src:str, best: bool = False) -> str: 
     return solve_ultimate(src, None, 30, best)
 
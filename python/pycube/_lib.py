@@ -3,12 +3,13 @@ import os
 import platform 
 
 
-__all__ = [ 'c_solve_ultimate', 'c_facecube', 'c_permutation', 'c_solvable' ]
+__all__ = [ 'c_init_solver', 'c_init_solver_async', 'c_solver_ready', 'c_wait_solver', 'c_solver_backing', 'c_set_solver_tier', 'c_get_solver_tier', 'c_solver_tier_info', 'c_set_solver_endgame', 'c_solve_ultimate', 'c_solve_optimal', 'c_solve_anytime', 'c_facecube', 'c_permutation', 'c_solvable' ]
 
 
 CUBE_BS = 128
 CUBE_ID = "UUUUUUUUURRRRRRRRRFFFFFFFFFDDDDDDDDDLLLLLLLLLBBBBBBBBB"
 DEFAULT_STEP=30
+TABLES_READY = 2    # enum table_state
 
 from .exceptions import check_status 
 
@@ -44,9 +45,44 @@ def _load_library():
 
 _cube_lib = _load_library() 
 
+_cube_lib.init_solver.argtypes = []
+_cube_lib.init_solver.restype = ctypes.c_int
+
+_cube_lib.init_solver_async.argtypes = []
+_cube_lib.init_solver_async.restype = ctypes.c_int
+
+_cube_lib.solver_state.argtypes = []
+_cube_lib.solver_state.restype = ctypes.c_int
+
+_cube_lib.wait_solver.argtypes = [ctypes.c_int]
+_cube_lib.wait_solver.restype = ctypes.c_int
+
+_cube_lib.solver_backing.argtypes = [ctypes.c_char_p]
+_cube_lib.solver_backing.restype = None
+
+_cube_lib.set_solver_tier.argtypes = [ctypes.c_int]
+_cube_lib.set_solver_tier.restype = ctypes.c_int
+
+_cube_lib.get_solver_tier.argtypes = []
+_cube_lib.get_solver_tier.restype = ctypes.c_int
+
+_cube_lib.solver_tier_info.argtypes = [ctypes.c_int, ctypes.c_char_p]
+_cube_lib.solver_tier_info.restype = ctypes.c_longlong
+
+_cube_lib.set_solver_endgame.argtypes = [ctypes.c_int]
+_cube_lib.set_solver_endgame.restype = ctypes.c_int
+
 _cube_lib.solve_ultimate.argtypes = [ctypes.c_char_p, ctypes.c_char_p,  ctypes.c_char_p, ctypes.c_int, ctypes.c_int]
 _cube_lib.solve_ultimate.restype = ctypes.c_int
 
+_cube_lib.solve_optimal.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int, ctypes.c_int, ctypes.POINTER(ctypes.c_int)]
+_cube_lib.solve_optimal.restype = ctypes.c_int
+
+_solve_callback = ctypes.CFUNCTYPE(None, ctypes.c_char_p, ctypes.c_void_p)
+_cube_lib.solve_anytime.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int, 
+                                    ctypes.c_longlong, ctypes.c_longlong, ctypes.c_int, _solve_callback, ctypes.c_void_p]
+_cube_lib.solve_anytime.restype = ctypes.c_int
+
 _cube_lib.facecube.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p]
 _cube_lib.facecube.restype = None
 
@@ -57,6 +93,46 @@ _cube_lib.permutation.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
 _cube_lib.permutation.restype = None
 
 
+def c_init_solver():
+    check_status(_cube_lib.init_solver())
+
+
+def c_init_solver_async():
+    check_status(_cube_lib.init_solver_async())
+
+
+def c_solver_ready():
+    return _cube_lib.solver_state() == TABLES_READY
+
+
+def c_wait_solver(timeout_ms):
+    return _cube_lib.wait_solver(timeout_ms)
+
+
+def c_solver_backing():
+    buffer = ctypes.create_string_buffer(CUBE_BS)
+    _cube_lib.solver_backing(buffer)
+    return buffer.value.decode('utf-8')
+
+
+def c_set_solver_tier(tier):
+    check_status(_cube_lib.set_solver_tier(tier))
+
+
+def c_get_solver_tier():
+    return _cube_lib.get_solver_tier()
+
+
+def c_solver_tier_info(tier):
+    buffer = ctypes.create_string_buffer(CUBE_BS)
+    size = _cube_lib.solver_tier_info(tier, buffer)
+    return size, buffer.value.decode('utf-8')
+
+
+def c_set_solver_endgame(depth):
+    check_status(_cube_lib.set_solver_endgame(depth))
+
+
 def c_solve_ultimate(src_bytes, tgt_bytes, step, best):
     buffer = ctypes.create_string_buffer(CUBE_BS)
     result_code = _cube_lib.solve_ultimate(
@@ -70,6 +146,20 @@ def c_solve_ultimate(src_bytes, tgt_bytes, step, best):
     return buffer.value.decode('utf-8')
 
 
+def c_solve_optimal(src_bytes, tgt_bytes, step):
+    buffer = ctypes.create_string_buffer(CUBE_BS)
+    bound = ctypes.c_int(0)
+    check_status(_cube_lib.solve_optimal(src_bytes, tgt_bytes, buffer, step, 1, ctypes.byref(bound)))
+    return buffer.value.decode('utf-8'), bound.value
+
+
+def c_solve_anytime(src_bytes, tgt_bytes, step, deadline_us, max_nodes, improved):
+    buffer = ctypes.create_string_buffer(CUBE_BS)
+    callback = _solve_callback(lambda s, _: improved(s.decode('utf-8'))) if improved else _solve_callback()
+    check_status(_cube_lib.solve_anytime(src_bytes, tgt_bytes, buffer, step, deadline_us, max_nodes, 1, callback, None))
+    return buffer.value.decode('utf-8')
+
+
 def c_facecube(cube_bytes, maneuver_bytes):
     buffer = ctypes.create_string_buffer(CUBE_BS)
     _cube_lib.facecube(cube_bytes, maneuver_bytes, buffer)
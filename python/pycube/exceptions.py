@@ -9,6 +9,15 @@ class StatusCode(IntEnum):
     INVALID_SRC = 3
     INVALID_TGT = 4
     UNKNOWN_ERROR = 5
+    NOT_READY = 6
+
+
+class Tier(IntEnum):
+    """ The tiers of solver tables (see `pycube.set_tier`) """
+    MINIMAL = 0
+    STANDARD = 1
+    LARGE = 2
+    EXACT = 3
 
 
 class CubeError(Exception):
@@ -28,6 +37,8 @@ def check_status(result_code: int):
         msg = "The cube configuration is unsolvable."
     elif code == StatusCode.NOT_FOUND:
         msg = "No solution found within the step limit."
+    elif code == StatusCode.NOT_READY:
+        msg = "The solver tables are still loading."
     else:
         msg = "Unknown error occurred."
     raise CubeError(result_code, msg)
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "codec.hh"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace codec {
+
+static constexpr unsigned prob_bits = 12;
+static constexpr uint32_t prob_scale = 1u << prob_bits;
+static constexpr uint32_t rans_low = 1u << 23;     // states are in [rans_low, rans_low << 8)
+
+/* the model of a lane: symbol frequencies and their cumulative starts */
+struct Model
+{
+    std::array<uint16_t,256> freq {};
+    std::array<uint16_t,256> start {};
+    std::array<uint8_t,prob_scale> sym {};      // slot -> symbol
+
+    /* fill `start` and `sym` from `freq`, false if freq does not sum up to the scale */
+    bool init()
+    {
+        uint32_t c = 0;
+        for(unsigned s = 0; s < 256; s++) {
+            if(freq[s] > prob_scale - c) return false;
+            start[s] = static_cast<uint16_t>(c);
+            std::fill_n(sym.begin() + c, freq[s], static_cast<uint8_t>(s));
+            c += freq[s];
+        }
+        return c == prob_scale;
+    }
+};
+
+/* scale the counts of byte values to frequencies summing to prob_scale,
+ * keeping every present value at least 1 */
+static void normalize(const std::array<uint64_t,256> &count, std::array<uint16_t,256> &freq)
+{
+    uint64_t total = 0;
+    for(auto c: count) total += c;
+    if(total == 0) { freq.fill(0), freq[0] = prob_scale; return; }
+    uint32_t sum = 0;
+    for(unsigned s = 0; s < 256; s++) {
+        freq[s] = count[s] ? std::max<uint64_t>(1, count[s] * prob_scale / total) : 0;
+        sum += freq[s];
+    }
+    // the rounding error goes to (or comes from) the most frequent values
+    while(sum != prob_scale) {
+        auto it = std::max_element(freq.begin(), freq.end());
+        if(sum < prob_scale) *it += prob_scale - sum, sum = prob_scale;
+        else (*it)--, sum--;
+    }
+}
+
+std::vector<char> encode(const void *src, size_t n, unsigned width)
+{
+    const auto *p = static_cast<const uint8_t*>(src);
+    width = std::max(1u, width);
+    std::vector<Model> lanes(width);
+    {
+        std::vector<std::array<uint64_t,256>> count(width);
+        for(size_t i = 0; i < n; i++) count[i % width][p[i]]++;
+        for(unsigned l = 0; l < width; l++) normalize(count[l], lanes[l].freq), lanes[l].init();
+    }
+
+    // symbols are encoded backward, so that they are decoded forward
+    std::vector<uint8_t> stream(2 * n + 16);
+    uint8_t *const end = stream.data() + stream.size();
+    uint8_t *ptr = end;
+    uint32_t x[2] = { rans_low, rans_low };
+    for(size_t i = n; i-- > 0;) {
+        const auto &md = lanes[i % width];
+        const uint32_t f = md.freq[p[i]];
+        auto &xs = x[i & 1];
+        const uint32_t x_max = ((rans_low >> prob_bits) << 8) * f;
+        while(xs >= x_max) *--ptr = static_cast<uint8_t>(xs), xs >>= 8;
+        xs = ((xs / f) << prob_bits) + (xs % f) + md.start[p[i]];
+    }
+
+    const size_t header = width * sizeof(Model::freq) + sizeof(x);
+    std::vector<char> out(header + (end - ptr));
+    char *q = out.data();
+    for(const auto &md: lanes) std::memcpy(q, md.freq.data(), sizeof(md.freq)), q += sizeof(md.freq);
+    std::memcpy(q, x, sizeof(x)), q += sizeof(x);
+    std::memcpy(q, ptr, end - ptr);
+    return out;
+}
+
+template<unsigned W>
+static bool decode_lanes(const std::vector<Model> &lanes, uint32_t (&x)[2],
+                         const uint8_t *q, const uint8_t *qend, uint8_t *d, size_t n)
+{
+    for(size_t i = 0; i < n; i++) {
+        const auto &md = lanes[i % W];
+        auto &xs = x[i & 1];
+        const uint32_t slot = xs & (prob_scale - 1);
+        const uint8_t s = md.sym[slot];
+        xs = md.freq[s] * (xs >> prob_bits) + slot - md.start[s];
+        while(xs < rans_low) {
+            if(q == qend) return false;
+            xs = (xs << 8) | *q++;
+        }
+        d[i] = s;
+    }
+    // the states end where the encoder started
+    return q == qend && x[0] == rans_low && x[1] == rans_low;
+}
+
+bool decode(const void *src, size_t m, void *dst, size_t n, unsigned width)
+{
+    width = std::max(1u, width);
+    const size_t header = width * sizeof(Model::freq) + 2 * sizeof(uint32_t);
+    if(m < header) return false;
+    const auto *q = static_cast<const uint8_t*>(src);
+    std::vector<Model> lanes(width);
+    for(auto &md: lanes) {
+        std::memcpy(md.freq.data(), q, sizeof(md.freq)), q += sizeof(md.freq);
+        if(!md.init()) return false;
+    }
+    uint32_t x[2];
+    std::memcpy(x, q, sizeof(x)), q += sizeof(x);
+    const auto *qend = static_cast<const uint8_t*>(src) + m;
+    auto *d = static_cast<uint8_t*>(dst);
+    switch(width) {
+        case 1:     return decode_lanes<1>(lanes, x, q, qend, d, n);
+        case 2:     return decode_lanes<2>(lanes, x, q, qend, d, n);
+        case 4:     return decode_lanes<4>(lanes, x, q, qend, d, n);
+        default:    return false;
+    }
+}
+
+} // namespace codec
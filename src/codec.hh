@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*!
+ * @brief Lossless compression of table data, for table bundles
+ * @details
+ * Tables have a small alphabet (depths, distances mod 3) with a skewed
+ * distribution but short runs, so each byte is entropy coded by its static
+ * frequency (order 0) with rANS, which decodes at a few hundred MB/s per
+ * core. The bytes of a `width`-byte entry are modelled separately ("lanes"),
+ * since e.g. the high byte of a 16-bit coord spans fewer values than the
+ * low one. Two rANS states are interleaved so that decoding is not bound
+ * by the latency of one state.
+ * Layout of encoded data:
+ *   - per lane, the frequencies of the 256 byte values (uint16, scaled to
+ *     2^12);
+ *   - the initial states (2 x uint32) and the byte stream.
+ */
+namespace codec {
+
+/* encode the `n` bytes at `src` of `width`-byte entries (width = 1, 2 or 4) */
+std::vector<char> encode(const void *src, size_t n, unsigned width);
+
+/* decode `m` bytes at `src` into the `n` bytes at `dst`;
+ * false if `src` is malformed (the data is not verified) */
+bool decode(const void *src, size_t m, void *dst, size_t n, unsigned width);
+
+} // namespace codec
@@ -124,7 +124,7 @@ EdgePerm Coord::see2ep(int slice, int edge4, int edge8)
     auto slice_indices = lexicalOrderToIndices<12,4>(slice);
     EdgePerm ep;
     for(size_t i = 0, j = 0, x = 0, y = 0; i < 12; i++) {
-        ep[i] = (i == slice_indices[j] && ++j) ? e4[x++]+8: e8[y++]+0;
+        ep[i] = (j < 4 && i == slice_indices[j] && ++j) ? e4[x++]+8: e8[y++]+0;
     }
     return ep;
 }
@@ -130,6 +130,7 @@ enum Constant {
     N_TWIST     = 2187,     // 3^7, corner twist
     N_FLIP      = 2048,     // 2^11, edge flip
     N_SLICE     = 495,      // C(12,4), 4 ud-slices in correct locations, order omitted
+    N_FLIPSLICE = 1013760,  // N_SLICE*N_FLIP, flipslice = slice*N_FLIP+flip
     N_CORNER    = 40320,    // 8!, corners permutation
     N_EDGE8     = 40320,    // 8!, ud-edges permutation
     N_EDGE4     = 24,       // 4!, the order of 4 ud-slices
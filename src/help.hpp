@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <array>
 #include <set>
@@ -122,6 +123,27 @@ struct NArray
     const auto & operator[](size_t i) const {
         return data[i];
     }
+    /* the row-major flat view of data */
+    T* flat() { return reinterpret_cast<T*>(&data); }
+    const T* flat() const { return reinterpret_cast<const T*>(&data); }
+};
+
+/* the array of 2-bit values, packed 4 per byte; indexed by its row-major flat index */
+template<size_t... Ns>
+struct PackedNArray
+{
+    using value_type = uint8_t;
+    static constexpr size_t size = (Ns * ...);
+    static constexpr size_t dim = sizeof...(Ns);
+    static constexpr std::array<size_t,dim> shape { Ns... };
+    std::array<uint8_t,(size+3)/4> data;
+    uint8_t get(size_t i) const { 
+        return (data[i >> 2] >> ((i & 3) << 1)) & 3; 
+    }
+    void set(size_t i, uint8_t v) { 
+        auto sh = (i & 3) << 1;
+        data[i >> 2] = (data[i >> 2] & ~(3 << sh)) | (v << sh);
+    }
 };
 
 template<size_t N,typename T>
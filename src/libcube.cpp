@@ -2,6 +2,13 @@
 #include "help.hpp"
 #include "utils.hpp"
 #include "twophase.hh"
+#include "optimal.hh"
+#include <chrono>
+#include <cstdio>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 const char* CornerToString[8]       = { "urf", "ufl", "ulb", "ubr", "dfr", "dlf", "dbl", "drb" };
 const char* EdgeToString[12]        = { "ur","uf","ul","ub","dr","df","dl","db","fr","fl","bl","br" };
@@ -12,8 +19,6 @@ const char* ColorSet                = "URFDLB";
 
 const std::string cid = CUBE_ID;
 
-TwoPhaseSolver TPS;
-
 std::string moves_to_string(const std::vector<TurnMove> &ms, std::string sep = " ") 
 {
     std::string r;
@@ -23,7 +28,174 @@ std::string moves_to_string(const std::vector<TurnMove> &ms, std::string sep = "
     return r;
 }
 
-int solve_ultimate(const char *src, const char* tgt, char* solution_buffer, int step, int best, int formated)
+/* the state of tables warmed up by init_solver_async */
+static std::mutex               warm_mutex;
+static std::condition_variable  warm_cv;
+static table_state              warm_state = TABLES_NONE;
+
+/* whether the tables (of the tier in table_option) were requested */
+static bool tables_requested = false;
+
+int init_solver()
+{
+    {
+        std::lock_guard<std::mutex> lk(warm_mutex);
+        tables_requested = true;
+    }
+    try {
+        TwoPhaseSolver::init();
+    } catch(...) {
+        return CODE_UNKNOWN_ERROR;
+    }
+    return CODE_OK;
+}
+
+int init_solver_async()
+{
+    {
+        std::lock_guard<std::mutex> lk(warm_mutex);
+        if(warm_state == TABLES_LOADING || warm_state == TABLES_READY) return CODE_OK;
+        warm_state = TABLES_LOADING;
+    }
+    auto warm = []() {
+        int rc = init_solver();
+        std::lock_guard<std::mutex> lk(warm_mutex);
+        warm_state = rc == CODE_OK ? TABLES_READY : TABLES_FAILED;
+        warm_cv.notify_all();
+    };
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    warm(); // no threads in wasm without pthreads
+#else
+    std::thread(warm).detach();
+#endif
+    return CODE_OK;
+}
+
+int solver_state()
+{
+    std::lock_guard<std::mutex> lk(warm_mutex);
+    return warm_state;
+}
+
+int wait_solver(int timeout_ms)
+{
+    std::unique_lock<std::mutex> lk(warm_mutex);
+    auto done = []() { return warm_state != TABLES_LOADING; };
+    if(timeout_ms < 0) warm_cv.wait(lk, done);
+    else warm_cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), done);
+    switch(warm_state) {
+        case TABLES_READY:  return CODE_OK;
+        case TABLES_FAILED: return CODE_UNKNOWN_ERROR;
+        default:            return CODE_NOT_READY;
+    }
+}
+
+/* the table options of `tier` */
+static TableOption tier_option(int tier)
+{
+    auto opt = table_option();
+    opt.sym_ph1 = tier >= TIER_STANDARD;
+    opt.sym_ph2 = tier >= TIER_LARGE;
+    opt.exact_ph2 = tier >= TIER_EXACT;
+    return opt;
+}
+
+int set_solver_tier(int tier)
+{
+    if(tier < TIER_MINIMAL || tier > TIER_EXACT) return CODE_UNKNOWN_ERROR;
+    std::lock_guard<std::mutex> lk(warm_mutex);
+    if(tables_requested) return tier == get_solver_tier() ? CODE_OK : CODE_UNKNOWN_ERROR;
+    auto &opt = table_option();
+    opt.sym_ph1 = tier >= TIER_STANDARD;
+    opt.sym_ph2 = tier >= TIER_LARGE;
+    opt.exact_ph2 = tier >= TIER_EXACT;
+    return CODE_OK;
+}
+
+int get_solver_tier()
+{
+    const auto &opt = table_option();
+    if(!opt.sym_ph1) return TIER_MINIMAL;
+    if(opt.exact_ph2) return TIER_EXACT;
+    return opt.sym_ph2 ? TIER_LARGE : TIER_STANDARD;
+}
+
+int set_solver_endgame(int depth)
+{
+    if(depth < 0 || depth > 7) return CODE_UNKNOWN_ERROR;
+    std::lock_guard<std::mutex> lk(warm_mutex);
+    auto &opt = table_option();
+    if(tables_requested) return unsigned(depth) == opt.endgame ? CODE_OK : CODE_UNKNOWN_ERROR;
+    opt.endgame = depth;
+    return CODE_OK;
+}
+
+long long solver_tier_info(int tier, char *buffer)
+{
+    // the median time per random cube, measured on one core
+    static const char *trade_off[] = {
+        "minimal: %zuMB; phase 1 bounded by slice x twist/flip, phase 2 by edge4 x corner/edge8; %s",
+        "standard: %zuMB; phase 1 exact, phase 2 bounded by edge4 x corner/edge8; %s",
+        "large: %zuMB; phase 1 exact, phase 2 bounded by corner x edge8 too; %s",
+        "exact: %zuMB; both phases exact, phase 2 descends straight; %s",
+    };
+    static const char *speed[] = { 
+        "~1s/cube (up to ~20s)", "~1s/cube (up to ~15s)", "~0.1ms/cube", "~0.03ms/cube" 
+    };
+    if(tier < TIER_MINIMAL || tier > TIER_EXACT) return -1;
+    size_t bytes = TwoPhaseSolver::footprint(tier_option(tier));
+    std::snprintf(buffer, CUBE_BS, trade_off[tier], (bytes + (1 << 19)) >> 20, speed[tier]);
+    return static_cast<long long>(bytes);
+}
+
+void solver_backing(char *buffer)
+{
+    auto b = TwoPhaseSolver::backing();
+    // in MB, as unsigned so that the worst case (127 chars) fits in CUBE_BS
+    auto mb = [](size_t n) { return static_cast<unsigned>((n + (1 << 19)) >> 20); };
+    std::snprintf(buffer, CUBE_BS, 
+        "tables %uMB: mapped %u, hugetlb %u, thp %u, locked %u, numa %u/%u nodes",
+        mb(b.total), mb(b.mapped), mb(b.hugetlb), mb(b.thp), mb(b.locked), mb(b.interleaved), b.nodes);
+}
+
+/* the maneuver of solutions s1 (phase 1) and s2 (phase 2) */
+static std::vector<TurnMove> join_solution(const std::vector<TurnMove> &s1, const std::vector<TurnMove> &s2)
+{
+    std::vector<TurnMove> solution; 
+    size_t n1 = s1.size(), n2 = s2.size();
+    // if the transition moves of ph1-ph2 are homogeneous, combine them
+    if(!s1.empty() && !s2.empty() && s1[n1-1]/3 == s2[0]/3) {
+        std::copy(s1.begin(), s1.end()-1, std::back_inserter(solution));
+        int m = (s1[n1-1] + s2[0]- s2[0]/3 *6 +2) %4;
+        if(m!=0) solution.push_back(static_cast<TurnMove>(s2[0]/3*3+m-1));
+        std::copy(s2.begin()+1, s2.end(), std::back_inserter(solution));
+    } else {
+        std::copy(s1.begin(), s1.end(), std::back_inserter(solution));
+        std::copy(s2.begin(), s2.end(), std::back_inserter(solution));
+    }
+    return solution;
+}
+
+/* write `sol` to `solution_buffer` (see `formated` of solve_ultimate) */
+static void write_solution(const std::vector<TurnMove> &sol, int formated, char *solution_buffer)
+{
+    if(formated == 0) {
+        for(size_t i = 0; i < sol.size(); i++) {
+            solution_buffer[i] = static_cast<char>(1 + sol[i]); // shift by 1 since 0 terminates the c-string
+        }
+        solution_buffer[sol.size()] = '\0';
+    } else {
+        auto s = moves_to_string(sol," ");
+        std::copy(s.cbegin(), s.cend(), solution_buffer);
+        solution_buffer[s.length()] = '\0';
+    }
+}
+
+/* solve_ultimate, which also sets `bound` (nullable) with SOLVE_OPTIMAL, 
+ * or searches within `budget` (nullable), calling `ready` (may be empty) once
+ * the cube is checked and the tables are loaded, right before the search */
+static int solve_impl(const char *src, const char* tgt, char* solution_buffer, int step, int best, int formated, 
+                      int *bound, const SolveBudget *budget = nullptr, const std::function<void()> &ready = {})
 {
     auto s_src = src == NULL ? cid : std::string(src);
     auto s_tgt = tgt == NULL ? cid : std::string(tgt);
@@ -36,47 +208,82 @@ int solve_ultimate(const char *src, const char* tgt, char* solution_buffer, int
     auto cc_tgt = (s_tgt == cid) ? CubieCube::id : CubieCube::fromString(s_tgt);
     
     // trivial cube
-    if(cc_src == cc_tgt) { solution_buffer[0] = '\0'; return CODE_OK; }
+    if(cc_src == cc_tgt) { 
+        if(bound) *bound = 0;
+        solution_buffer[0] = '\0'; 
+        return CODE_OK; 
+    }
 
     CubieCube cc = ~cc_tgt*cc_src;
 
     // unsolvable
     if(!cc.isSolvable()) return CODE_UNSOLVABLE;
     
-    const auto & [found, s1, s2] = TPS.solve(Coord::CubieCube2Coord(cc), step, best);
+    if(solver_state() == TABLES_LOADING) return CODE_NOT_READY;
+    if(int rc = init_solver(); rc != CODE_OK) return rc;
+    if(best & SOLVE_OPTIMAL) {
+        try { OptimalSolver::init(); } catch(...) { return CODE_UNKNOWN_ERROR; }
+    }
+    if(ready) ready();
+    const auto c = Coord::CubieCube2Coord(cc);
+    // the search state is per call, the tables are shared (read-only), so
+    // that calls may run concurrently
+    TwoPhaseSolver solver;
+    std::tuple<bool,std::vector<TurnMove>,std::vector<TurnMove>> result;
+    // no exception may escape to C callers: the searches throw on tables found
+    // inconsistent (e.g. a corrupted mapped bundle, whose checksums are not 
+    // verified by default), or on failures of memory or threads
+    try {
+        result = [&]() {
+            if(best & SOLVE_OPTIMAL) {
+                auto [found, s, b] = OptimalSolver::solve(c, step);
+                if(bound) *bound = b;
+                return std::make_tuple(found, s, std::vector<TurnMove>{});
+            }
+            if(budget) return solver.solve(c, step, *budget);
+            if(best & SOLVE_PARALLEL) return TwoPhaseSolver::solve_parallel(c, step, best & SOLVE_BEST);
+            if(best & SOLVE_SPLIT) return solver.solve_split(c, step, best & SOLVE_BEST);
+            return solver.solve(c, step, best & SOLVE_BEST);
+        }();
+    } catch(...) {
+        return CODE_UNKNOWN_ERROR;
+    }
+    const auto & [found, s1, s2] = result;
 
-    // solution is not found since the search depth is too small
+    // solution is not found since the search depth (or budget) is too small
     if(!found) return CODE_NOT_FOUND;
     
-    std::vector<TurnMove> sol = [](const auto &s1, const auto &s2) {
-        std::vector<TurnMove> solution; 
-        size_t n1 = s1.size(), n2 = s2.size();
-        // if the transition moves of ph1-ph2 are homogeneous, combine them
-        if(!s1.empty() && !s2.empty() && s1[n1-1]/3 == s2[0]/3) {
-            std::copy(s1.begin(), s1.end()-1, std::back_inserter(solution));
-            int m = (s1[n1-1] + s2[0]- s2[0]/3 *6 +2) %4;
-            if(m!=0) solution.push_back(static_cast<TurnMove>(s2[0]/3*3+m-1));
-            std::copy(s2.begin()+1, s2.end(), std::back_inserter(solution));
-        } else {
-            std::copy(s1.begin(), s1.end(), std::back_inserter(solution));
-            std::copy(s2.begin(), s2.end(), std::back_inserter(solution));
-        }
-        return solution;
-    }(s1,s2);
-
-    if(formated == 0) {
-        for(size_t i = 0; i < sol.size(); i++) {
-            solution_buffer[i] = static_cast<char>(1 + sol[i]); // shift by 1 since 0 terminates the c-string
-        }
-        solution_buffer[sol.size()] = '\0';
-    } else {
-        auto s = moves_to_string(sol," ");
-        std::copy(s.cbegin(), s.cend(), solution_buffer);
-        solution_buffer[s.length()] = '\0';
-    }
+    write_solution(join_solution(s1, s2), formated, solution_buffer);
     return CODE_OK;
 }
 
+int solve_ultimate(const char *src, const char* tgt, char* solution_buffer, int step, int best, int formated)
+{
+    return solve_impl(src, tgt, solution_buffer, step, best, formated, nullptr);
+}
+
+int solve_optimal(const char *src, const char* tgt, char* solution_buffer, int step, int formated, int *bound)
+{
+    return solve_impl(src, tgt, solution_buffer, step, SOLVE_OPTIMAL, formated, bound);
+}
+
+int solve_anytime(const char *src, const char* tgt, char* solution_buffer, int step, 
+                  long long deadline_us, long long max_nodes, int formated, solve_callback improved, void *user)
+{
+    SolveBudget budget;
+    if(max_nodes > 0) budget.max_nodes = static_cast<size_t>(max_nodes);
+    if(improved) budget.improved = [=](const auto &s1, const auto &s2) {
+        char buffer[CUBE_BS];
+        write_solution(join_solution(s1, s2), formated, buffer);
+        improved(buffer, user);
+    };
+    // the budget covers the search, not checking the cube nor loading the tables
+    auto start = [&]() {
+        if(deadline_us > 0) budget.deadline = SolveBudget::clock::now() + std::chrono::microseconds(deadline_us);
+    };
+    return solve_impl(src, tgt, solution_buffer, step, SOLVE_BEST, formated, nullptr, &budget, start);
+}
+
 int solve(const char *src, char* sol_buffer, int best)
 {
     return solve_ultimate(src,NULL,sol_buffer,30,best,1);
@@ -0,0 +1,207 @@
+#include "optimal.hh"
+#include "symmetry.hh"
+#include "parallel.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <stdexcept>
+
+using TPS = TwoPhaseSolver;
+
+/* the tables bound by OptimalSolver::init: the move tables of both phases
+ * and the tables of TABLE_OPT */
+static const TableMove<>        *TM1 = nullptr, *TM2 = nullptr;
+static const TableSymmetry<>    *TSO = nullptr;
+static const TablePrunning<>    *TPO = nullptr;
+
+void OptimalSolver::init()
+{
+    SingletonTP<TABLE_OPT>::pending();
+    TPS::init();
+    static const bool ready = [](){
+        TM1 = &SingletonTM<TABLE_PH1>::instance();
+        TM2 = &SingletonTM<TABLE_PH2>::instance();
+        TSO = &SingletonTS<TABLE_OPT>::instance();
+        TPO = &SingletonTP<TABLE_OPT>::instance();
+        return true;
+    }();
+    (void)ready;
+}
+
+struct OptimalSolver::Node
+{
+    std::array<Coord,3>     ax;     // the phase 1 coords along the 3 axes
+    std::array<size_t,3>    d3;     // their depth3 (see TwoPhaseSolver::depth3)
+    int                     corner; // the corner permutation
+    size_t                  c3;     // the depth of corners (see corner_depth)
+};
+
+/* the entry of (corner, twist) in the corner table (depth mod 3) */
+static size_t corner_mod3(int corner, int twist)
+{
+    auto cs = (*TSO->pTSCorner)[corner];
+    return TPO->pTPCornerTwist->get((cs >> 4) * N_TWIST + (*TSO->pTSTwistConj)[twist][cs & 15]);
+}
+
+/* the depth of (corner, twist) in the corner table, recovered from `d3` of
+ * its neighbor in the search tree */
+static size_t corner_depth(int corner, int twist, size_t d3)
+{
+    switch((corner_mod3(corner, twist) + 3 - d3 % 3) % 3) {
+        case 1:     return d3 + 1;
+        case 2:     return d3 - 1;
+        default:    return d3;
+    }
+}
+
+/* the depth of (corner, twist) in the corner table, recovered by descending
+ * to the origin; for search roots */
+static size_t corner_depth(int corner, int twist)
+{
+    const auto &mtCorner = *TM2->pTMCornerC;
+    const auto &mtTwist = *TM1->pTMTwistC;
+    size_t d = 0;
+    for(size_t r = corner_mod3(corner, twist); corner != 0 || twist != 0; d++, r = (r + 2) % 3) {
+        int m = 0;
+        while(m < N_MOVE && corner_mod3(mtCorner[corner][m], mtTwist[twist][m]) != (r + 2) % 3) m++;
+        if(m == N_MOVE) throw std::logic_error("inconsistent prunning table");
+        corner = mtCorner[corner][m], twist = mtTwist[twist][m];
+    }
+    return d;
+}
+
+/* whether move m may follow move `last` (-1: none) in a canonical maneuver */
+static bool is_canonical(int last, int m)
+{
+    return last < 0 || (m/3 != last/3 && m/3 + 3 != last/3);
+}
+
+/* the moves conjugated by S_URF3^u: s*(x*m)*s^-1 = (s*x*s^-1) * S[16u]*m*S[16u]^-1 */
+static const std::array<std::array<TurnMove,N_MOVE>,3>& conj_move()
+{
+    static const auto t = [](){
+        std::array<std::array<TurnMove,N_MOVE>,3> t;
+        for(int u = 0; u < 3; u++) for(int m = 0; m < N_MOVE; m++) {
+            auto x = Sym::conj(16 * u, ElementaryMove[m]);
+            t[u][m] = static_cast<TurnMove>(std::find(ElementaryMove.begin(), ElementaryMove.end(), x) - ElementaryMove.begin());
+        }
+        return t;
+    }();
+    return t;
+}
+
+auto OptimalSolver::root_node_(const CubieCube &cc) -> Node
+{
+    Node n;
+    for(int u = 0; u < 3; u++) {
+        n.ax[u] = Coord::CubieCube2Coord(Sym::conj(16 * u, cc));
+        n.d3[u] = TPS::depth3<TPS::Ph1>(n.ax[u]);
+    }
+    n.corner = n.ax[0].corner;
+    n.c3 = corner_depth(n.corner, n.ax[0].twist);
+    return n;
+}
+
+bool OptimalSolver::expand_(const Node &n, int m, int togo, Node &x)
+{
+    // the cheap corner bound first
+    x.corner = (*TM2->pTMCornerC)[n.corner][m];
+    x.ax[0] = TPS::transform<TPS::Ph1>(n.ax[0], static_cast<TurnMove>(m));
+    x.c3 = corner_depth(x.corner, x.ax[0].twist, n.c3);
+    if(int(x.c3) > togo) return false;
+    for(int u = 0; u < 3; u++) {
+        if(u > 0) x.ax[u] = TPS::transform<TPS::Ph1>(n.ax[u], conj_move()[u][m]);
+        x.d3[u] = TPS::depth3<TPS::Ph1>(x.ax[u], n.d3[u]);
+        if(int(TPS::distance<TPS::Ph1>(x.ax[u], x.d3[u])) > togo) return false;
+    }
+    return true;
+}
+
+int OptimalSolver::bound_(const Node &n)
+{
+    size_t h = n.c3;
+    for(int u = 0; u < 3; u++) h = std::max(h, TPS::distance<TPS::Ph1>(n.ax[u], n.d3[u]));
+    return int(h);
+}
+
+struct OptimalSolver::Search
+{
+    CubieCube                   root;
+    const std::atomic<int>     *first;  // the first task that found a solution
+    int                         task;
+    std::vector<int>            path;   // the maneuver so far
+    size_t                      nodes = 0;
+
+    /* search `n` (at `path`) for a solution of exactly `togo` more moves */
+    bool dfs(const Node &n, int togo)
+    {
+        nodes++;
+        if(togo == 0) {
+            // the bounds are all 0 on cubes other than id, verify the maneuver
+            auto cc = root;
+            for(auto m: path) cc = cc * ElementaryMove[m];
+            return cc == CubieCube::id;
+        }
+        if(first->load(std::memory_order_relaxed) < task) return false;
+        int last = path.empty() ? -1 : path.back();
+        Node x;
+        for(int m = 0; m < N_MOVE; m++) {
+            if(!is_canonical(last, m) || !expand_(n, m, togo - 1, x)) continue;
+            path.push_back(m);
+            if(dfs(x, togo - 1)) return true;
+            path.pop_back();
+        }
+        return false;
+    }
+};
+
+auto OptimalSolver::solve(const Coord &c, int step, unsigned threads)
+    -> std::tuple<bool,std::vector<TurnMove>,int>
+{
+    init();
+
+    const auto cc = Coord::Coord2CubieCube(c);
+    const auto root = root_node_(cc);
+    TaskPool pool(thread_count(threads));
+    // depths below the bound of the root are exhausted by pruning
+    for(int d = bound_(root); d <= step; d++) {
+        auto t0 = std::chrono::steady_clock::now();
+        // the subtrees: the canonical prefixes of min(d,2) moves
+        std::vector<std::pair<std::vector<int>,Node>> subs { { {}, root } };
+        for(int k = 0; k < std::min(d, 2); k++) {
+            decltype(subs) next;
+            for(auto &[p, n]: subs) for(int m = 0; m < N_MOVE; m++) {
+                Node x;
+                if(!is_canonical(p.empty() ? -1 : p.back(), m) || !expand_(n, m, d - k - 1, x)) continue;
+                auto q = p;
+                q.push_back(m);
+                next.emplace_back(std::move(q), x);
+            }
+            subs = std::move(next);
+        }
+
+        std::atomic<int> first { INT_MAX };
+        std::vector<Search> searches(subs.size());
+        std::vector<TaskPool::Handle> tasks;
+        for(int i = 0; i < int(subs.size()); i++) tasks.push_back(pool.submit([&,i]() {
+            auto &s = searches[i];
+            s.root = cc, s.first = &first, s.task = i, s.path = subs[i].first;
+            if(!s.dfs(subs[i].second, d - int(s.path.size()))) return;
+            for(int f = first.load(); i < f && !first.compare_exchange_weak(f, i); );
+        }));
+        for(auto &t: tasks) pool.wait(t);
+
+        size_t nodes = 0;
+        for(auto &s: searches) nodes += s.nodes;
+        VPRINT("optimal depth %d: %zu nodes in %.3fs\n", d, nodes,
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+        (void)nodes, (void)t0;
+        if(int f = first.load(); f != INT_MAX) {
+            std::vector<TurnMove> sol;
+            for(auto m: searches[f].path) sol.push_back(static_cast<TurnMove>(m));
+            return std::make_tuple(true, sol, d);
+        }
+    }
+    return std::make_tuple(false, std::vector<TurnMove>{}, step + 1);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "def.h"
+#include "coord.hh"
+#include "cube.hh"
+#include "twophase.hh"
+
+#include <tuple>
+#include <vector>
+
+/*!
+ * @brief The optimal solver: IDA* over all 18 moves
+ * @details
+ * A node is pruned by the max of two lower bounds of its distance:
+ *  - the phase 1 distance (see TwoPhaseSolver::distance) of the cube seen
+ *    along each of the 3 axes (conjugated by S_URF3^k), since a solved cube
+ *    is in phase 2 along all of them;
+ *  - the distance of its corners (permutation and twist), from the pattern
+ *    database of TABLE_OPT (see TablePrunning::pTPCornerTwist).
+ * Maneuvers are canonical: a face is never turned twice in a row, and of
+ * two opposite faces turned in a row, U/R/F goes first.
+ *
+ * Each depth is split at the root by the first two moves into subtrees,
+ * searched as tasks of a thread pool; the solution of the first subtree (in
+ * move order) holding one is returned, so the result does not depend on the
+ * thread count. Random cubes take from minutes to hours (~18 moves); the
+ * mode is meant for cubes up to ~15 moves and for proving lower bounds.
+ */
+class OptimalSolver
+{
+public:
+
+    /*!
+     * @brief Solve `c` in the fewest moves, if within `step` moves
+     * @param threads   the count of threads (0 => hardware concurrency)
+     * @return (is_solved,solution,bound): every maneuver shorter than `bound`
+     *         was exhausted (searched or pruned), so bound = |solution| if
+     *         solved (which proves it optimal), step+1 otherwise
+     */
+    static auto solve(const Coord &c, int step, unsigned threads = 0)
+        -> std::tuple<bool,std::vector<TurnMove>,int>;
+
+    /* load (or build) the tables of the solver (TABLE_OPT and both phases),
+     * if not yet; `solve` calls it on first use. (throw) on failures */
+    static void init();
+
+private:
+    struct Node;    // a node of the search
+    struct Search;  // the DFS of a subtree
+
+    /* the root node of cube `cc` */
+    static Node root_node_(const CubieCube &cc);
+
+    /* the child `x` of `n` by move m, false if it is pruned at `togo` moves
+     * left (x is then partial) */
+    static bool expand_(const Node &n, int m, int togo, Node &x);
+
+    /* the lower bound of the distance of `n` */
+    static int bound_(const Node &n);
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* the count of worker threads: `n` if positive, otherwise the hardware concurrency */
+inline unsigned thread_count(unsigned n = 0)
+{
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    return 1; // no threads in wasm without pthreads
+#else
+    if(n > 0) return n;
+    return std::max(1u, std::thread::hardware_concurrency());
+#endif
+}
+
+/*!
+ * @brief A thread pool running tasks as soon as their dependencies are done
+ * @details
+ * A task submitted with dependencies is queued once all of them finish; if
+ * any of them fails, the task is not run and inherits the exception.
+ * `wait` runs queued tasks on the calling thread until the awaited task is
+ * done, so waiting inside a task never deadlocks and a pool of `n` threads
+ * spawns only `n-1` workers (none for n=1: everything runs within `wait`).
+ */
+class TaskPool
+{
+public:
+    struct Task
+    {
+        std::function<void()>               f;
+        size_t                              pending = 0;    // unfinished dependencies
+        std::vector<std::shared_ptr<Task>>  next;           // dependents
+        bool                                done = false;
+        std::exception_ptr                  error;
+    };
+    using Handle = std::shared_ptr<Task>;
+
+    explicit TaskPool(unsigned n_thread)
+    {
+        for(unsigned i = 1; i < n_thread; i++) workers_.emplace_back([this](){ work(); });
+    }
+    TaskPool(const TaskPool &) = delete;
+    TaskPool& operator=(const TaskPool &) = delete;
+    ~TaskPool()
+    {
+        { std::lock_guard<std::mutex> lk(m_); stop_ = true; }
+        cv_.notify_all();
+        for(auto &w: workers_) w.join();
+    }
+
+    size_t size() const { return workers_.size() + 1; }
+
+    /* submit `f` to run after `deps` (null handles are ignored) */
+    Handle submit(std::function<void()> f, const std::vector<Handle> &deps = {})
+    {
+        auto t = std::make_shared<Task>();
+        t->f = std::move(f);
+        std::lock_guard<std::mutex> lk(m_);
+        for(auto &d: deps) {
+            if(!d) continue;
+            if(!d->done) d->next.push_back(t), t->pending++;
+            else if(d->error && !t->error) t->error = d->error;
+        }
+        if(t->pending == 0) ready_.push_back(t), cv_.notify_one();
+        return t;
+    }
+
+    /* wait for `t` (helping with queued tasks), rethrow its exception */
+    void wait(const Handle &t)
+    {
+        if(!t) return;
+        std::unique_lock<std::mutex> lk(m_);
+        while(!t->done) {
+            if(!ready_.empty()) run_one(lk);
+            else cv_.wait(lk);
+        }
+        if(t->error) std::rethrow_exception(t->error);
+    }
+
+    /* call f(begin,end) on blocks of [0,n) in parallel and wait for all */
+    template<typename F>
+    void parallel_for(size_t n, size_t block, F &&f)
+    {
+        block = std::max<size_t>(1, block);
+        std::vector<Handle> hs;
+        for(size_t b = 0; b < n; b += block) {
+            size_t e = std::min(n, b + block);
+            hs.push_back(submit([&f,b,e](){ f(b,e); }));
+        }
+        for(auto &h: hs) wait(h);
+    }
+
+private:
+    /* pop and run a queued task; called with `lk` locked */
+    void run_one(std::unique_lock<std::mutex> &lk)
+    {
+        auto t = ready_.front();
+        ready_.pop_front();
+        lk.unlock();
+        if(!t->error) {
+            try { t->f(); } catch(...) { t->error = std::current_exception(); }
+        }
+        t->f = nullptr;
+        lk.lock();
+        t->done = true;
+        for(auto &n: t->next) {
+            if(t->error && !n->error) n->error = t->error;
+            if(--n->pending == 0) ready_.push_back(n);
+        }
+        t->next.clear();
+        cv_.notify_all();
+    }
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lk(m_);
+        while(true) {
+            cv_.wait(lk, [this](){ return stop_ || !ready_.empty(); });
+            if(ready_.empty()) return;
+            run_one(lk);
+        }
+    }
+
+    std::mutex                  m_;
+    std::condition_variable     cv_;
+    std::deque<Handle>          ready_;
+    std::vector<std::thread>    workers_;
+    bool                        stop_ = false;
+};
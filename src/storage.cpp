@@ -0,0 +1,496 @@
+#include "storage.hh"
+#include "codec.hh"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/file.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+#ifdef __linux__
+    #include <sys/syscall.h>
+#endif
+
+namespace fs = std::filesystem;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const fs::path &path)
+{
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("cannot open " + path.string());
+    LARGE_INTEGER sz;
+    if(!GetFileSizeEx(file, &sz) || sz.QuadPart == 0) {
+        CloseHandle(file);
+        throw std::runtime_error("cannot map empty file " + path.string());
+    }
+    handle_ = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file); // the mapping object keeps the file open
+    if(handle_ == NULL) throw std::runtime_error("cannot map " + path.string());
+    addr_ = MapViewOfFile(handle_, FILE_MAP_READ, 0, 0, 0);
+    if(addr_ == NULL) {
+        CloseHandle(handle_);
+        throw std::runtime_error("cannot map " + path.string());
+    }
+    size_ = static_cast<size_t>(sz.QuadPart);
+}
+
+MappedFile::~MappedFile()
+{
+    if(addr_) UnmapViewOfFile(addr_);
+    if(handle_) CloseHandle(handle_);
+}
+
+FileLock::FileLock(const fs::path &path)
+{
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) throw std::runtime_error("cannot open " + path.string());
+    OVERLAPPED ov {};
+    if(!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &ov)) {
+        CloseHandle(file);
+        throw std::runtime_error("cannot lock " + path.string());
+    }
+    handle_ = file;
+}
+
+FileLock::~FileLock()
+{
+    OVERLAPPED ov {};
+    UnlockFileEx(handle_, 0, MAXDWORD, MAXDWORD, &ov);
+    CloseHandle(handle_);
+}
+
+#else
+
+MappedFile::MappedFile(const fs::path &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) throw std::runtime_error("cannot open " + path.string());
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot map empty file " + path.string());
+    }
+    // no MAP_POPULATE: pages are faulted in lazily on first access
+    void *addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file referenced
+    if(addr == MAP_FAILED) throw std::runtime_error("cannot map " + path.string());
+    addr_ = addr;
+    size_ = static_cast<size_t>(st.st_size);
+}
+
+MappedFile::~MappedFile()
+{
+    if(addr_) ::munmap(addr_, size_);
+}
+
+FileLock::FileLock(const fs::path &path)
+{
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(fd_ < 0) throw std::runtime_error("cannot open " + path.string());
+    int rc;
+    while((rc = ::flock(fd_, LOCK_EX)) != 0 && errno == EINTR);
+    if(rc != 0) {
+        ::close(fd_);
+        throw std::runtime_error("cannot lock " + path.string());
+    }
+}
+
+FileLock::~FileLock()
+{
+    ::close(fd_); // releases the lock
+}
+
+#endif
+
+MemoryBacking& MemoryBacking::operator+=(const MemoryBacking &b)
+{
+    total += b.total, mapped += b.mapped, hugetlb += b.hugetlb, thp += b.thp;
+    locked += b.locked, interleaved += b.interleaved, nodes = std::max(nodes, b.nodes);
+    return *this;
+}
+
+static constexpr size_t huge_page = size_t(2) << 20;
+
+#ifdef __linux__
+
+/* the online NUMA nodes as a bitmask for mbind, and their count */
+static std::vector<unsigned long> numa_nodes(unsigned &count)
+{
+    constexpr unsigned B = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask;
+    std::ifstream f("/sys/devices/system/node/online"); // e.g. "0-1,3"
+    std::string line, range;
+    count = 0;
+    if(!std::getline(f, line)) return mask;
+    std::stringstream ss(line);
+    while(std::getline(ss, range, ',')) {
+        unsigned a, b;
+        int n = std::sscanf(range.c_str(), "%u-%u", &a, &b);
+        if(n < 1) continue;
+        if(n == 1) b = a;
+        for(unsigned i = a; i <= b && i < 1024; i++) {
+            if(mask.size() <= i / B) mask.resize(i / B + 1, 0);
+            mask[i / B] |= 1UL << (i % B);
+            count++;
+        }
+    }
+    return mask;
+}
+
+/* the bytes of mappings overlapping [addr,addr+size) on transparent huge pages */
+static size_t anon_huge_bytes(const void *addr, size_t size)
+{
+    const auto b = reinterpret_cast<uintptr_t>(addr), e = b + size;
+    std::ifstream f("/proc/self/smaps");
+    std::string line;
+    bool in = false;
+    size_t kb = 0;
+    while(std::getline(f, line)) {
+        unsigned long lo, hi;
+        size_t v;
+        if(std::sscanf(line.c_str(), "%lx-%lx ", &lo, &hi) == 2) in = lo < e && hi > b;
+        else if(in && std::sscanf(line.c_str(), "AnonHugePages: %zu kB", &v) == 1) kb += v;
+    }
+    return kb * 1024;
+}
+
+#endif
+
+bool lock_memory(const void *addr, size_t size)
+{
+#if defined(_WIN32)
+    return VirtualLock(const_cast<void*>(addr), size) != 0;
+#elif defined(__EMSCRIPTEN__)
+    return false;
+#else
+    const auto page = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+    auto b = reinterpret_cast<uintptr_t>(addr) / page * page;
+    return ::mlock(reinterpret_cast<void*>(b), reinterpret_cast<uintptr_t>(addr) + size - b) == 0;
+#endif
+}
+
+TableMemory::TableMemory(size_t size, const MemoryOption &opt)
+:size_(size)
+{
+    const bool placed = opt.pages != MemoryOption::PAGES_DEFAULT || opt.interleave || opt.lock;
+#if defined(_WIN32)
+    if(placed) {
+        addr_ = VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if(addr_ == NULL) throw std::bad_alloc();
+        len_ = size;
+        if(opt.lock) locked_ = lock_memory(addr_, size);
+        return;
+    }
+#elif !defined(__EMSCRIPTEN__)
+    if(placed) {
+        const bool huge = opt.pages != MemoryOption::PAGES_DEFAULT && size >= huge_page;
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    #ifdef __linux__
+        if(huge && opt.pages == MemoryOption::PAGES_HUGETLB) {
+            size_t len = (size + huge_page - 1) / huge_page * huge_page;
+            void *p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, 
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if(p != MAP_FAILED) addr_ = p, len_ = len, hugetlb_ = true;
+        }
+    #endif
+        if(!addr_) {
+            // over-allocate to align to huge pages, then trim the excess
+            const size_t align = huge ? huge_page : page;
+            const size_t len = (size + page - 1) / page * page;
+            const size_t extra = align > page ? align : 0;
+            void *p = ::mmap(nullptr, len + extra, PROT_READ | PROT_WRITE, 
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(p == MAP_FAILED) throw std::bad_alloc();
+            auto b = reinterpret_cast<uintptr_t>(p), a = (b + align - 1) / align * align;
+            if(a > b) ::munmap(p, a - b);
+            if(b + extra > a) ::munmap(reinterpret_cast<void*>(a + len), b + extra - a);
+            addr_ = reinterpret_cast<void*>(a), len_ = len;
+    #ifdef __linux__
+            if(huge) ::madvise(addr_, len_, MADV_HUGEPAGE);
+    #endif
+        }
+    #ifdef __linux__
+        if(opt.interleave) {
+            const int MPOL_INTERLEAVE = 3;
+            unsigned count;
+            auto mask = numa_nodes(count);
+            if(count > 1 && ::syscall(SYS_mbind, addr_, len_, MPOL_INTERLEAVE, mask.data(), 
+                                      mask.size() * 8 * sizeof(unsigned long) + 1, 0) == 0)
+                nodes_ = count;
+        }
+    #endif
+        if(opt.lock) locked_ = lock_memory(addr_, len_);
+        return;
+    }
+#endif
+    (void)placed;
+    addr_ = std::calloc(1, size);
+    if(!addr_) throw std::bad_alloc();
+}
+
+TableMemory::~TableMemory()
+{
+    if(!len_) std::free(addr_);
+#if defined(_WIN32)
+    else VirtualFree(addr_, 0, MEM_RELEASE);
+#elif !defined(__EMSCRIPTEN__)
+    else ::munmap(addr_, len_);
+#endif
+}
+
+MemoryBacking TableMemory::backing() const
+{
+    MemoryBacking b;
+    b.total = size_;
+    if(hugetlb_) b.hugetlb = size_;
+#ifdef __linux__
+    else if(len_) b.thp = std::min(size_, anon_huge_bytes(addr_, len_));
+#endif
+    if(locked_) b.locked = size_;
+    if(nodes_) b.interleaved = size_, b.nodes = nodes_;
+    return b;
+}
+
+/* 64-bit FNV-1a over 8-byte words (and the trailing bytes) */
+static uint64_t checksum(const void *data, size_t n)
+{
+    const uint64_t prime = 0x100000001b3ULL;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    const auto *p = static_cast<const unsigned char*>(data);
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        h = (h ^ w) * prime;
+    }
+    for(; i < n; i++) h = (h ^ p[i]) * prime;
+    return h;
+}
+
+static const char bundle_magic[8] = "CUBETBL";
+static constexpr uint64_t bundle_align = 4096;
+
+bool TableBundle::validate(const Header &h, const std::vector<Entry> &index, uint64_t size) const
+{
+    if(std::memcmp(h.magic, bundle_magic, sizeof(h.magic)) != 0 || h.version != version) return false;
+    if(checksum(index.data(), index.size() * sizeof(Entry)) != h.checksum) return false;
+    for(const auto &e: index) {
+        if(e.offset > size || e.stored > size - e.offset) return false;
+        if(e.encoding == ENCODING_RAW && e.stored != e.bytes) return false;
+    }
+    return true;
+}
+
+TableBundle::TableBundle(const fs::path &path, bool mmap)
+:path_(path)
+{
+    std::error_code ec;
+    auto fsize = fs::file_size(path, ec);
+    if(ec || fsize < sizeof(Header)) return;
+    std::ifstream f(path, std::ios::binary);
+    Header h;
+    if(!f.read(reinterpret_cast<char*>(&h), sizeof(h))) return;
+    if(h.count > (fsize - sizeof(Header)) / sizeof(Entry)) return;
+    std::vector<Entry> index(h.count);
+    if(!f.read(reinterpret_cast<char*>(index.data()), h.count * sizeof(Entry))) return;
+    if(!validate(h, index, fsize)) return;
+    if(mmap && !index.empty()) {
+        map_ = std::make_unique<MappedFile>(path);
+        base_ = static_cast<const char*>(map_->data());
+    }
+    index_ = std::move(index);
+}
+
+TableBundle::TableBundle(const void *data, size_t size)
+:verify_(false)
+{
+    if(size < sizeof(Header)) return;
+    Header h;
+    std::memcpy(&h, data, sizeof(h));
+    if(h.count > (size - sizeof(Header)) / sizeof(Entry)) return;
+    std::vector<Entry> index(h.count);
+    std::memcpy(index.data(), static_cast<const char*>(data) + sizeof(Header), h.count * sizeof(Entry));
+    if(!validate(h, index, size)) return;
+    base_ = static_cast<const char*>(data);
+    index_ = std::move(index);
+}
+
+const TableBundle::Entry* TableBundle::find(const Section &s) const
+{
+    for(const auto &e: index_) {
+        if(std::strncmp(e.name, s.name.c_str(), sizeof(e.name)) != 0) continue;
+        if(e.bits != s.bits || e.dim != s.shape.size() || e.bytes != s.bytes) return nullptr;
+        for(size_t i = 0; i < s.shape.size(); i++) if(e.shape[i] != s.shape[i]) return nullptr;
+        return &e;
+    }
+    return nullptr;
+}
+
+const void* TableBundle::map(const Section &s, bool verify) const
+{
+    const Entry *e = find(s);
+    if(!e || !base_ || e->encoding != ENCODING_RAW) return nullptr;
+    const char *p = base_ + e->offset;
+    return !(verify && verify_) || checksum(p, e->bytes) == e->checksum ? p : nullptr;
+}
+
+/* the bytes per lane of the codec for entries of `bits` */
+static unsigned codec_width(uint32_t bits)
+{
+    return bits >= 32 ? 4 : bits >= 16 ? 2 : 1;
+}
+
+bool TableBundle::read(const Section &s, void *dst) const
+{
+    const Entry *e = find(s);
+    if(!e) return false;
+    if(e->encoding == ENCODING_RAW) {
+        if(base_) {
+            std::memcpy(dst, base_ + e->offset, e->bytes);
+        } else {
+            std::ifstream f(path_, std::ios::binary);
+            if(!f.seekg(e->offset) || !f.read(static_cast<char*>(dst), e->bytes)) return false;
+        }
+    } else if(e->encoding == ENCODING_RANS) {
+        // decode straight into `dst`, from the mapping or a copy of the stored bytes
+        std::vector<char> buf;
+        const char *src = base_ ? base_ + e->offset : nullptr;
+        if(!src) {
+            buf.resize(e->stored);
+            std::ifstream f(path_, std::ios::binary);
+            if(!f.seekg(e->offset) || !f.read(buf.data(), e->stored)) return false;
+            src = buf.data();
+        }
+        if(!codec::decode(src, e->stored, dst, e->bytes, codec_width(e->bits))) return false;
+    } else {
+        return false;
+    }
+    return !verify_ || checksum(dst, e->bytes) == e->checksum;
+}
+
+TableBundle::Section TableBundle::section(const Entry &e)
+{
+    std::string name(e.name, std::find(e.name, e.name + sizeof(e.name), '\0'));
+    Section s { name, e.bits, std::vector<uint64_t>(e.shape, e.shape + std::min<uint32_t>(e.dim, 4)), e.bytes };
+    s.stored = e.stored;
+    return s;
+}
+
+std::vector<TableBundle::Section> TableBundle::sections() const
+{
+    std::vector<Section> ss;
+    for(const auto &e: index_) ss.push_back(section(e));
+    return ss;
+}
+
+void TableBundle::publish(const fs::path &path, const std::vector<Section> &sections, bool compress)
+{
+    static std::mutex m; // publishers in one process take turns
+    std::lock_guard<std::mutex> lk(m);
+
+    // keep the valid sections of the current bundle
+    TableBundle old(path, false);
+    std::vector<Section> all = sections;
+    std::vector<std::unique_ptr<char[]>> kept;
+    for(const auto &e: old.index_) {
+        Section s = section(e);
+        bool replaced = false;
+        for(const auto &x: sections) replaced |= x.name == s.name;
+        if(replaced) continue;
+        kept.emplace_back(new char[e.bytes]);
+        if(!old.read(s, kept.back().get())) continue;
+        s.data = kept.back().get();
+        all.push_back(s);
+    }
+
+    Header h {};
+    std::memcpy(h.magic, bundle_magic, sizeof(h.magic));
+    h.version = version;
+    h.count = static_cast<uint32_t>(all.size());
+    std::vector<Entry> index(all.size());
+    std::vector<std::vector<char>> encoded(all.size());
+    // compressed sections cannot be mapped anyway
+    const uint64_t align = compress ? 8 : bundle_align;
+    uint64_t offset = sizeof(Header) + all.size() * sizeof(Entry);
+    for(size_t i = 0; i < all.size(); i++) {
+        const auto &s = all[i];
+        auto &e = index[i];
+        if(s.name.size() >= sizeof(e.name) || s.shape.size() > 4)
+            throw std::invalid_argument("cannot bundle table " + s.name);
+        std::memset(&e, 0, sizeof(e));
+        std::memcpy(e.name, s.name.data(), s.name.size());
+        e.bits = s.bits, e.dim = static_cast<uint32_t>(s.shape.size());
+        std::copy(s.shape.begin(), s.shape.end(), e.shape);
+        offset = (offset + align - 1) / align * align;
+        e.offset = offset, e.bytes = s.bytes, e.checksum = checksum(s.data, s.bytes);
+        e.encoding = ENCODING_RAW, e.stored = s.bytes;
+        if(compress) {
+            encoded[i] = codec::encode(s.data, s.bytes, codec_width(s.bits));
+            if(encoded[i].size() < s.bytes) e.encoding = ENCODING_RANS, e.stored = encoded[i].size();
+            else encoded[i].clear();
+        }
+        offset += e.stored;
+    }
+    h.checksum = checksum(index.data(), index.size() * sizeof(Entry));
+
+#ifdef _WIN32
+    auto pid = std::to_string(_getpid());
+#else
+    auto pid = std::to_string(::getpid());
+#endif
+    fs::path tmp = path;
+    tmp += ".tmp." + pid;
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if(!f) throw std::runtime_error("cannot write " + tmp.string());
+        f.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        f.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(Entry));
+        for(size_t i = 0; i < all.size(); i++) {
+            const std::vector<char> pad(index[i].offset - static_cast<uint64_t>(f.tellp()), 0);
+            f.write(pad.data(), pad.size());
+            if(index[i].encoding == ENCODING_RAW) f.write(static_cast<const char*>(all[i].data), all[i].bytes);
+            else f.write(encoded[i].data(), encoded[i].size());
+        }
+        f.close();
+        if(!f) {
+            fs::remove(tmp);
+            throw std::runtime_error("cannot write " + tmp.string());
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if(ec) {
+        fs::remove(tmp);
+        throw std::runtime_error("cannot rename " + tmp.string() + ": " + ec.message());
+    }
+}
+
+void TableBundle::sweep(const fs::path &path)
+{
+    const auto prefix = path.filename().string() + ".tmp.";
+    std::error_code ec;
+    for(fs::directory_iterator it(path.parent_path(), ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code ec_rm;
+        if(it->path().filename().string().rfind(prefix, 0) == 0) fs::remove(it->path(), ec_rm);
+    }
+}
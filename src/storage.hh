@@ -0,0 +1,212 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*!
+ * @brief How the memory of tables is placed
+ * @details All modes are best effort: what was obtained is reported by 
+ * MemoryBacking. Huge pages only apply to tables of at least one huge page.
+ *  - pages: default pages; transparent huge pages (madvise); or explicit 
+ *    huge pages (MAP_HUGETLB, needs reserved pages, otherwise falls back to
+ *    transparent ones);
+ *  - interleave: spread pages round-robin over NUMA nodes;
+ *  - lock: mlock the memory, so that it is never paged out.
+ * Huge pages and NUMA are Linux only; locking is POSIX / Windows.
+ */
+struct MemoryOption
+{
+    enum Pages { PAGES_DEFAULT, PAGES_THP, PAGES_HUGETLB };
+    Pages   pages       = PAGES_DEFAULT;
+    bool    interleave  = false;
+    bool    lock        = false;
+};
+
+/* the backing of table memory obtained, in bytes */
+struct MemoryBacking
+{
+    size_t  total       = 0;
+    size_t  mapped      = 0;    // file mappings
+    size_t  hugetlb     = 0;    // explicit huge pages
+    size_t  thp         = 0;    // currently on transparent huge pages
+    size_t  locked      = 0;
+    size_t  interleaved = 0;
+    unsigned nodes      = 1;    // NUMA nodes interleaved over
+
+    MemoryBacking& operator+=(const MemoryBacking &b);
+};
+
+/* lock the pages of [addr,addr+size) in memory (best effort), return whether locked */
+bool lock_memory(const void *addr, size_t size);
+
+/*!
+ * @brief Anonymous memory for a table, placed by MemoryOption
+ * @details The memory is zero-filled and released on destruction.
+ */
+class TableMemory
+{
+public:
+    TableMemory(size_t size, const MemoryOption &opt);
+    TableMemory(const TableMemory &) = delete;
+    TableMemory& operator=(const TableMemory &) = delete;
+    ~TableMemory();
+
+    void*   data() const { return addr_; }
+    size_t  size() const { return size_; }
+
+    /* the backing obtained; THP is queried now since pages may be merged later */
+    MemoryBacking backing() const;
+
+private:
+    void*       addr_ = nullptr;
+    size_t      size_ = 0;
+    size_t      len_ = 0;       // mapped length, 0 if allocated by new
+    bool        hugetlb_ = false, locked_ = false;
+    unsigned    nodes_ = 0;     // NUMA nodes interleaved over, 0 if not
+};
+
+/*!
+ * @brief Read-only memory mapping of a whole file
+ * @details
+ * Pages are loaded lazily on first access (page fault) and are backed by
+ * the page cache, so processes mapping the same file share one physical
+ * copy of it. The mapping is released on destruction.
+ * @note the mapped memory must not be written.
+ */
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path &path);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile& operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    void*   data() const { return addr_; }
+    size_t  size() const { return size_; }
+
+private:
+    void*   addr_ = nullptr;
+    size_t  size_ = 0;
+#ifdef _WIN32
+    void*   handle_ = nullptr;  // file mapping object
+#endif
+};
+
+/*!
+ * @brief An exclusive advisory lock on a file, among processes
+ * @details The file is created if absent. The constructor blocks until the 
+ * lock is obtained; it is released on destruction, or by the OS when the 
+ * process dies. flock (POSIX) / LockFileEx (Windows); throw if the file 
+ * cannot be opened.
+ * @note a process must hold one FileLock per file: on POSIX, a second lock
+ * on the same file in the same process blocks.
+ */
+class FileLock
+{
+public:
+    explicit FileLock(const std::filesystem::path &path);
+    FileLock(const FileLock &) = delete;
+    FileLock& operator=(const FileLock &) = delete;
+    ~FileLock();
+
+private:
+#ifdef _WIN32
+    void*   handle_ = nullptr;
+#else
+    int     fd_ = -1;
+#endif
+};
+
+/*!
+ * @brief A versioned file bundling named tables
+ * @details
+ * Layout (native byte order):
+ *   - header:   magic "CUBETBL", format version, count of sections and the
+ *               checksum of the section index;
+ *   - index:    per section, its name, bits per entry, shape, encoding, 
+ *               offset, size (decoded and stored) and checksum (decoded);
+ *   - sections: at offsets aligned to 4096, so that they can be mapped; 
+ *               raw, or compressed (see codec.hh) to distribute bundles, 
+ *               which are then decoded by `read` but cannot be mapped.
+ * The header and index are validated on opening; a section is returned only
+ * if its layout matches, and is read only if its checksum is verified; a 
+ * mapped section is verified only on demand, since that touches every page
+ * of it (defeating the lazy loading of the mapping). A bundle is written 
+ * to a temporary file which is then renamed over the old one, so readers 
+ * only ever see a complete bundle. A bundle may also be given in memory
+ * (e.g. linked into the library), whose checksums are then trusted.
+ */
+class TableBundle
+{
+public:
+    static constexpr uint32_t version = 2;
+
+    enum Encoding : uint32_t { ENCODING_RAW = 0, ENCODING_RANS = 1 };
+
+    struct Section
+    {
+        std::string             name;
+        uint32_t                bits;   // per entry
+        std::vector<uint64_t>   shape;
+        uint64_t                bytes;
+        const void             *data = nullptr; // to publish
+        uint64_t                stored = 0;     // bytes in the bundle (see `sections`)
+    };
+
+    /* open the bundle at `path` (empty if absent or invalid) to map or read */
+    TableBundle(const std::filesystem::path &path, bool mmap);
+    /* the bundle in memory [data, data+size) (empty if invalid) to map */
+    TableBundle(const void *data, size_t size);
+    TableBundle(const TableBundle &) = delete;
+    TableBundle& operator=(const TableBundle &) = delete;
+
+    /* (mmap or in memory) the data of section `s`, nullptr if absent or invalid
+     * (including its checksum if `verify`) */
+    const void* map(const Section &s, bool verify = false) const;
+
+    /* read (and decode) section `s` into `dst`, false if absent or invalid */
+    bool read(const Section &s, void *dst) const;
+
+    /* the sections in the bundle (without data) */
+    std::vector<Section> sections() const;
+
+    /* write `sections`, and the valid sections at `path` not among them, 
+     * to a new bundle at `path`, compressed if `compress`; throw on 
+     * failures (`path` is untouched) */
+    static void publish(const std::filesystem::path &path, const std::vector<Section> &sections,
+                        bool compress = false);
+
+    /* remove the temporary files left at `path` by publishers that died; 
+     * (precondition) no other publisher is running */
+    static void sweep(const std::filesystem::path &path);
+
+private:
+    struct Header
+    {
+        char        magic[8];
+        uint32_t    version;
+        uint32_t    count;
+        uint64_t    checksum;   // of the index
+    };
+    struct Entry
+    {
+        char        name[32];
+        uint32_t    bits, dim, encoding, reserved;
+        uint64_t    shape[4];
+        uint64_t    offset, bytes, stored, checksum;
+    };
+    const Entry* find(const Section &s) const;
+    /* the section described by `e` */
+    static Section section(const Entry &e);
+    /* validate the header `h` and `index` of a bundle of `size` bytes */
+    bool validate(const Header &h, const std::vector<Entry> &index, uint64_t size) const;
+
+    std::filesystem::path       path_;
+    std::vector<Entry>          index_;
+    std::unique_ptr<MappedFile> map_;
+    const char                 *base_   = nullptr;  // mapped or in memory
+    bool                        verify_ = true;
+};
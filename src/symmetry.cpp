@@ -0,0 +1,96 @@
+#include "symmetry.hh"
+#include <stdexcept>
+
+SymCube SymCube::fromCubieCube(const CubieCube &cc)
+{
+    SymCube sc;
+    for(int i = 0; i < 8; i++)  sc.cp[i] = cc.cp[i], sc.co[i] = cc.co[i];
+    for(int i = 0; i < 12; i++) sc.ep[i] = cc.ep[i], sc.eo[i] = cc.eo[i];
+    return sc;
+}
+
+CubieCube SymCube::toCubieCube() const
+{
+    CubieCube cc;
+    for(int i = 0; i < 8; i++)  cc.cp[i] = cp[i], cc.co[i] = co[i];
+    for(int i = 0; i < 12; i++) cc.ep[i] = ep[i], cc.eo[i] = eo[i];
+    return cc;
+}
+
+SymCube operator*(const SymCube &a, const SymCube &b)
+{
+    SymCube c;
+    for(int i = 0; i < 8; i++) {
+        int oa = a.co[b.cp[i]], ob = b.co[i], o;
+        c.cp[i] = a.cp[b.cp[i]];
+        if(oa < 3 && ob < 3)    o = (oa + ob) % 3;
+        else if(oa < 3)         o = (oa + ob >= 6) ? oa + ob - 3 : oa + ob;  // b mirrored
+        else if(ob < 3)         o = (oa - ob < 3) ? oa - ob + 3 : oa - ob;   // a mirrored
+        else                    o = (oa - ob < 0) ? oa - ob + 3 : oa - ob;   // both mirrored
+        c.co[i] = o;
+    }
+    for(int i = 0; i < 12; i++) {
+        c.ep[i] = a.ep[b.ep[i]];
+        c.eo[i] = (a.eo[b.ep[i]] + b.eo[i]) % 2;
+    }
+    return c;
+}
+
+/* the symmetry cube of basic symmetry `s` (see CornerCubieSym, EdgeCubieSym) */
+static SymCube basic_sym(Symmetry s)
+{
+    SymCube sc;
+    for(int i = 0; i < 8; i++)  sc.cp[i] = CornerCubieSym[s][i].c, sc.co[i] = CornerCubieSym[s][i].o;
+    for(int i = 0; i < 12; i++) sc.ep[i] = EdgeCubieSym[s][i].e, sc.eo[i] = EdgeCubieSym[s][i].o;
+    return sc;
+}
+
+const std::array<SymCube,N_SYM>& Sym::cube()
+{
+    static const std::array<SymCube,N_SYM> S = [](){
+        std::array<SymCube,N_SYM> S;
+        SymCube cc = SymCube::fromCubieCube(CubieCube::id);
+        int k = 0;
+        for(int urf3 = 0; urf3 < 3; urf3++) {
+            for(int f2 = 0; f2 < 2; f2++) {
+                for(int u4 = 0; u4 < 4; u4++) {
+                    for(int lr2 = 0; lr2 < 2; lr2++) {
+                        S[k++] = cc;
+                        cc = cc * basic_sym(S_LR2);
+                    }
+                    cc = cc * basic_sym(S_U4);
+                }
+                cc = cc * basic_sym(S_F2);
+            }
+            cc = cc * basic_sym(S_URF3);
+        }
+        return S;
+    }();
+    return S;
+}
+
+int Sym::inv(int s)
+{
+    static const std::array<int,N_SYM> I = [](){
+        std::array<int,N_SYM> I;
+        const auto &S = Sym::cube();
+        const auto id = SymCube::fromCubieCube(CubieCube::id);
+        auto is_id = [&id](const SymCube &x) {
+            return x.cp == id.cp && x.co == id.co && x.ep == id.ep && x.eo == id.eo;
+        };
+        for(int i = 0; i < N_SYM; i++) {
+            int j = 0;
+            while(j < N_SYM && !is_id(S[i]*S[j])) j++;
+            if(j == N_SYM) throw std::logic_error("symmetry without inverse");
+            I[i] = j;
+        }
+        return I;
+    }();
+    return I[s];
+}
+
+CubieCube Sym::conj(int s, const CubieCube &x)
+{
+    const auto &S = Sym::cube();
+    return (S[s] * SymCube::fromCubieCube(x) * S[inv(s)]).toCubieCube();
+}
@@ -1 +1,44 @@
-// TODO: use symmetries to improve performance
\ No newline at end of file
+#pragma once
+#include "def.h"
+#include "cube.hh"
+
+#include <array>
+
+/*!
+ * @brief The cubie-level representation of cube symmetries
+ * @details
+ * Same schema ("replace-by") as CubieCube, but the corner orientation ranges
+ * over 0..5, where 3..5 denote mirrored corners; this makes reflections
+ * (e.g. S_LR2) representable and composable.
+ */
+struct SymCube
+{
+    std::array<int,8>   cp, co;
+    std::array<int,12>  ep, eo;
+
+    static SymCube fromCubieCube(const CubieCube &);
+    /* (precondition) no mirrored corners */
+    CubieCube toCubieCube() const;
+};
+
+SymCube operator*(const SymCube &a, const SymCube &b);
+
+/*!
+ * @brief The symmetries of cube
+ * @details
+ * The 48 symmetries are indexed by
+ *   S[16*urf3 + 8*f2 + 2*u4 + lr2] = S_URF3^urf3 * S_F2^f2 * S_U4^u4 * S_LR2^lr2
+ * so the first N_SYM_D4h of them form the D4h group, which preserves the UD
+ * axis and hence the phase 1/2 subgroups: d(s*x*s^-1) = d(x) for s in D4h.
+ */
+struct Sym
+{
+    /* the 48 symmetry cubes */
+    static const std::array<SymCube,N_SYM>& cube();
+
+    /* the index of inverse symmetry: S[inv(s)] = S[s]^-1 */
+    static int inv(int s);
+
+    /* the conjugation s * x * s^-1 */
+    static CubieCube conj(int s, const CubieCube &x);
+};
@@ -1,11 +1,47 @@
 #include "table.hh"
 #include "coord.hh"
+#include "storage.hh"
+#include "symmetry.hh"
+#include "parallel.hpp"
 #include "utils.hpp"
+#include <atomic>
 #include <filesystem>
 #include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <mutex>
 
 namespace fs = std::filesystem;
 
+TableOption& table_option()
+{
+    static TableOption opt = [](){
+        TableOption o;
+        if(const char *dir = std::getenv("CUBE_TABLE_DIR")) o.dir = dir;
+        if(const char *mm = std::getenv("CUBE_TABLE_MMAP")) o.mmap = std::strcmp(mm, "1") == 0;
+        if(const char *vf = std::getenv("CUBE_TABLE_VERIFY")) o.verify = std::strcmp(vf, "1") == 0;
+        if(const char *tr = std::getenv("CUBE_TABLE_TIER")) {
+            if(std::strcmp(tr, "minimal") == 0) o.sym_ph1 = false, o.sym_ph2 = false, o.exact_ph2 = false;
+            if(std::strcmp(tr, "standard") == 0) o.sym_ph1 = true, o.sym_ph2 = false, o.exact_ph2 = false;
+            if(std::strcmp(tr, "large") == 0) o.sym_ph1 = true, o.sym_ph2 = true, o.exact_ph2 = false;
+            if(std::strcmp(tr, "exact") == 0) o.sym_ph1 = true, o.sym_ph2 = true, o.exact_ph2 = true;
+        }
+        if(const char *sp = std::getenv("CUBE_TABLE_SYM_PH2")) o.sym_ph2 = std::strcmp(sp, "1") == 0;
+        if(const char *fs = std::getenv("CUBE_TABLE_FLIPSLICE")) o.flipslice = std::strcmp(fs, "1") == 0;
+        if(const char *ex = std::getenv("CUBE_TABLE_EXACT_PH2")) o.exact_ph2 = std::strcmp(ex, "1") == 0;
+        if(const char *eg = std::getenv("CUBE_TABLE_ENDGAME")) o.endgame = std::min(std::max(std::atoi(eg), 0), 7);
+        if(const char *nt = std::getenv("CUBE_TABLE_THREADS")) o.threads = std::atoi(nt);
+        if(const char *pg = std::getenv("CUBE_TABLE_PAGES")) {
+            if(std::strcmp(pg, "thp") == 0) o.memory.pages = MemoryOption::PAGES_THP;
+            if(std::strcmp(pg, "hugetlb") == 0) o.memory.pages = MemoryOption::PAGES_HUGETLB;
+        }
+        if(const char *nm = std::getenv("CUBE_TABLE_NUMA")) o.memory.interleave = std::strcmp(nm, "interleave") == 0;
+        if(const char *ml = std::getenv("CUBE_TABLE_MLOCK")) o.memory.lock = std::strcmp(ml, "1") == 0;
+        return o;
+    }();
+    return opt;
+}
+
 static fs::path table_dir_fallback(std::string dir) 
 {
     if(dir != "") return fs::path(dir);
@@ -20,146 +56,828 @@ static fs::path table_dir_fallback(std::string dir)
     }
 }
 
-template <typename Table>
-void save_to(const Table &table, fs::path path)
+#ifdef CUBE_EMBED_TABLES
+/* the bundle generated at build time (see embed_tables.cpp.in) */
+extern "C" const char cube_embedded_tables[], cube_embedded_tables_end[];
+#endif
+
+/* the bundle linked into the library, nullptr in slim builds */
+static const TableBundle* embedded_bundle()
+{
+#ifdef CUBE_EMBED_TABLES
+    static const TableBundle b(cube_embedded_tables, cube_embedded_tables_end - cube_embedded_tables);
+    return &b;
+#else
+    return nullptr;
+#endif
+}
+
+TableBase::TableBase(const TableOption &opt)
+:tdir(table_dir_fallback(opt.dir)), option(opt)
 {
-    std::ofstream f(path, std::ios::binary);
-    if(f.is_open()) {
-        f.write(reinterpret_cast<const char*>(&table.data), sizeof(table.data));
-        f.close();
+}
+
+/* the bundle section holding Table `name` */
+template<typename Table>
+static TableBundle::Section section_of(std::string name)
+{
+    return { name, static_cast<uint32_t>(sizeof(Table::data) * 8 / Table::size),
+             std::vector<uint64_t>(Table::shape.begin(), Table::shape.end()), sizeof(Table::data) };
+}
+
+/* the pool shared by table sets under construction, created on demand */
+static std::shared_ptr<TaskPool> build_pool(unsigned n_thread)
+{
+    static std::mutex m;
+    static std::weak_ptr<TaskPool> wp;
+    std::lock_guard<std::mutex> lk(m);
+    auto p = wp.lock();
+    if(!p) wp = p = std::make_shared<TaskPool>(n_thread);
+    return p;
+}
+
+/* the lock of table directory `dir` shared by the table sets of the process,
+ * obtained (blocking) on demand; null if it cannot be taken */
+static std::shared_ptr<FileLock> table_lock(const fs::path &dir)
+{
+    static std::mutex m;
+    static std::map<fs::path,std::weak_ptr<FileLock>> locks;
+    std::lock_guard<std::mutex> lk(m);
+    auto &wp = locks[dir];
+    auto p = wp.lock();
+    if(p) return p;
+    try {
+        if(!fs::exists(dir)) fs::create_directories(dir);
+        wp = p = std::make_shared<FileLock>(dir/TableBase::lock_file);
+        // no other process publishes now: remove what dead publishers left
+        TableBundle::sweep(dir/TableBase::bundle_file);
+    } catch(const std::exception &e) {
+        // e.g. a read-only directory: build without coordination
+        VPRINT("cannot lock tables: %s\n", e.what());
     }
+    return p;
 }
 
-template <typename Table>
-void load_from(Table &table, fs::path path)
+TaskPool::Handle TableBase::ready(const void *table) const
 {
-    VPRINT("loading table from %s...", path.c_str());
-    std::ifstream f(path,std::ios::binary);
-    f.read(reinterpret_cast<char*>(&table.data), sizeof(table.data));
-    f.close();
-    VPRINT("done.\n");
+    auto it = tasks_.find(table);
+    return it == tasks_.end() ? nullptr : it->second;
+}
+
+MemoryBacking TableBase::backing() const
+{
+    MemoryBacking b = mapped_;
+    for(auto *m: memory_) b += m->backing();
+    return b;
+}
+
+/* account for a table used in place, locking it if asked */
+static void map_in_place(MemoryBacking &b, const void *p, size_t size, const MemoryOption &opt)
+{
+    b.total += size, b.mapped += size;
+    if(opt.lock && lock_memory(p, size)) b.locked += size;
+}
+
+void TableBase::wait()
+{
+    try {
+        for(auto &[_, h]: tasks_) pool_->wait(h);
+    } catch(...) {
+        // nothing to publish, but other processes must not wait forever
+        tasks_.clear(), built_.clear();
+        pool_.reset(), lock_.reset();
+        throw;
+    }
+    tasks_.clear();
+    pool_.reset();
+    if(!built_.empty()) {
+        try {
+            if(!fs::exists(tdir)) fs::create_directories(tdir);
+            TableBundle::publish(tdir/bundle_file, built_);
+        } catch(const std::exception &e) {
+            // the tables stay usable; they are just built again next time
+            VPRINT("cannot cache tables: %s\n", e.what());
+        }
+        built_.clear();
+    }
+    lock_.reset();
+}
+
+void TableBase::open_bundle()
+{
+    bundle_ = std::make_shared<TableBundle>(tdir/bundle_file, option.mmap);
+    storage_.push_back(bundle_);
+}
+
+template<typename Table, typename Build>
+Table* TableBase::acquire(std::string name, Build &&build, std::vector<TaskPool::Handle> deps)
+{
+    auto sec = section_of<Table>(name);
+    Table *t = nullptr;     // the memory to read or build the table
+    // use the table of bundle `b` in place if `mmap`, otherwise (or if it is
+    // compressed) read it into memory
+    auto load = [&](const TableBundle &b, bool mmap) -> Table* {
+        if(mmap) {
+            if(auto p = b.map(sec, option.verify)) {
+                VPRINT("mapped table %s.\n", name.c_str());
+                map_in_place(mapped_, p, sizeof(Table), option.memory);
+                return reinterpret_cast<Table*>(const_cast<void*>(p));
+            }
+        }
+        if(!t) {
+            auto m = std::make_shared<TableMemory>(sizeof(Table), option.memory);
+            storage_.push_back(m);
+            memory_.push_back(m.get());
+            t = reinterpret_cast<Table*>(m->data());
+        }
+        if(b.read(sec, t)) {
+            VPRINT("loaded table %s.\n", name.c_str());
+            return t;
+        }
+        return nullptr;
+    };
+    if(auto *eb = embedded_bundle()) {
+        if(auto *p = load(*eb, true)) return p;
+    }
+    if(!bundle_) open_bundle();
+    if(auto *p = load(*bundle_, option.mmap)) return p;
+    if(!locked_) {
+        // another process may have built the table while we waited for the lock
+        locked_ = true;
+        lock_ = table_lock(tdir);
+        open_bundle();
+        if(auto *p = load(*bundle_, option.mmap)) return p;
+    }
+    if(!pool_) pool_ = build_pool(thread_count(option.threads));
+    tasks_[t] = pool_->submit([build, t](){ build(*t); }, deps);
+    sec.data = t;
+    built_.push_back(sec);
+    return t;
 }
 
 template<typename T>
 template<typename Table, typename F1, typename F2>
 std::enable_if_t<Table::shape[0] == N_MOVE>
-TableMove<T>::buildMoveTable(Table &t, F1&& coord2i, F2&& i2coord, std::string filename)
+TableMove<T>::buildMoveTable(Table &t, F1&& coord2i, F2&& i2coord, std::string name)
 {
     VPRINT("creating move table %s of shape (%zu,%zu)... ", 
-           filename.c_str(), t.shape[0], t.shape[1]);
-    for(size_t i = 0; i < t.shape[0]; i++) for(size_t j = 0; j < t.shape[1]; j++) {
-        t[i][j] = coord2i(i2coord(j) * ElementaryMove[i]);
+           name.c_str(), t.shape[0], t.shape[1]);
+    // rows (coords) are split among threads; each coord is decoded once
+    const size_t block = std::max<size_t>(1024, t.shape[1] / (8 * pool_->size()));
+    pool_->parallel_for(t.shape[1], block, [&](size_t j0, size_t j1) {
+        for(size_t j = j0; j < j1; j++) {
+            auto x = i2coord(j);
+            for(size_t i = 0; i < t.shape[0]; i++) t[i][j] = coord2i(x * ElementaryMove[i]);
+        }
+    });
+    VPRINT("done.\n");
+}
+
+template<typename T>
+template<typename Table, typename TF, typename TS>
+void TableMove<T>::buildFlipSliceTable(Table &t, const TF &flip, const TS &slice, std::string name)
+{
+    VPRINT("creating move table %s of shape (%zu,%zu)... ", 
+           name.c_str(), t.shape[0], t.shape[1]);
+    // flip and slice move independently
+    pool_->parallel_for(N_SLICE, 16, [&](size_t s0, size_t s1) {
+        for(size_t s = s0; s < s1; s++) for(size_t f = 0; f < N_FLIP; f++) {
+            for(size_t m = 0; m < N_MOVE; m++) t[s * N_FLIP + f][m] = slice[m][s] * N_FLIP + flip[m][f];
+        }
+    });
+    VPRINT("done.\n");
+}
+
+template<typename T>
+template<typename TableC, typename Table>
+std::enable_if_t<TableC::shape[0] == Table::shape[1] && TableC::shape[1] == TableMove<T>::row>
+TableMove<T>::buildCoordMajor(TableC &tc, const Table &t, std::string name)
+{
+    VPRINT("creating move table %s of shape (%zu,%zu)... ", 
+           name.c_str(), tc.shape[0], tc.shape[1]);
+    std::fill_n(tc.flat(), tc.size, 0);
+    for(size_t j = 0; j < t.shape[1]; j++) {
+        for(size_t i = 0; i < t.shape[0]; i++) tc[j][i] = t[i][j];
     }
-    if(filename != "") save_to(t, tdir/filename);
     VPRINT("done.\n");
 }
 
 template<typename T>
-TableMove<T>::TableMove(std::string dir)
-:tdir(table_dir_fallback(dir))
+size_t TableMove<T>::footprint(const TableOption &opt)
+{
+    const size_t n = N_TWIST + N_FLIP + N_SLICE + N_CORNER + N_EDGE4 + N_EDGE8;
+    return n * (N_MOVE + row) * sizeof(T) 
+         + (opt.flipslice ? sizeof(*pTMFlipSliceC) : 0);
+}
+
+template<typename T>
+TableMove<T>::TableMove(unsigned phases, const TableOption &opt)
+:TableBase(opt)
 {
     VPRINT("INIT MOVE TABLES -- \n");
-    pTMTwist     = new NArray<T,N_MOVE,N_TWIST>;
-    pTMFlip      = new NArray<T,N_MOVE,N_FLIP>;
-    pTMSlice     = new NArray<T,N_MOVE,N_SLICE>;
-    pTMCorner    = new NArray<T,N_MOVE,N_CORNER>;
-    pTMEdge4     = new NArray<T,N_MOVE,N_EDGE4>;
-    pTMEdge8     = new NArray<T,N_MOVE,N_EDGE8>;
-
-    if(!fs::exists(tdir/"tm_twist.dat")) {
-        if(!fs::exists(tdir)) fs::create_directories(tdir);
-        buildMoveTable(*pTMTwist, Coord::co2twist, Coord::twist2co, "tm_twist.dat");
-        buildMoveTable(*pTMFlip, Coord::eo2flip, Coord::flip2eo, "tm_flip.dat");
-        buildMoveTable(*pTMSlice, Coord::ep2slice, Coord::slice2ep, "tm_slice.dat");
-        buildMoveTable(*pTMCorner, Coord::cp2corner, Coord::corner2cp, "tm_corner.dat");
-        buildMoveTable(*pTMEdge4, Coord::ep2edge4, Coord::edge42ep, "tm_edge4.dat");
-        buildMoveTable(*pTMEdge8, Coord::ep2edge8, Coord::edge82ep, "tm_edge8.dat");
-    } else {
-        load_from(*pTMTwist, tdir/"tm_twist.dat");
-        load_from(*pTMFlip, tdir/"tm_flip.dat");
-        load_from(*pTMSlice, tdir/"tm_slice.dat");
-        load_from(*pTMCorner, tdir/"tm_corner.dat");
-        load_from(*pTMEdge4, tdir/"tm_edge4.dat");
-        load_from(*pTMEdge8, tdir/"tm_edge8.dat");
+    using C = Coord;
+    if(phases & TABLE_PH1) {
+        pTMTwist  = acquire<NArray<T,N_MOVE,N_TWIST>>("tm_twist", [this](auto &t){ 
+            buildMoveTable(t, C::co2twist, C::twist2co, "tm_twist"); });
+        pTMFlip   = acquire<NArray<T,N_MOVE,N_FLIP>>("tm_flip", [this](auto &t){ 
+            buildMoveTable(t, C::eo2flip, C::flip2eo, "tm_flip"); });
+        pTMSlice  = acquire<NArray<T,N_MOVE,N_SLICE>>("tm_slice", [this](auto &t){ 
+            buildMoveTable(t, C::ep2slice, C::slice2ep, "tm_slice"); });
+    }
+    if(phases & TABLE_PH2) {
+        pTMCorner = acquire<NArray<T,N_MOVE,N_CORNER>>("tm_corner", [this](auto &t){ 
+            buildMoveTable(t, C::cp2corner, C::corner2cp, "tm_corner"); });
+        pTMEdge4  = acquire<NArray<T,N_MOVE,N_EDGE4>>("tm_edge4", [this](auto &t){ 
+            buildMoveTable(t, C::ep2edge4, C::edge42ep, "tm_edge4"); });
+        pTMEdge8  = acquire<NArray<T,N_MOVE,N_EDGE8>>("tm_edge8", [this](auto &t){ 
+            buildMoveTable(t, C::ep2edge8, C::edge82ep, "tm_edge8"); });
+    }
+    // the coord-major layouts, derived from the move-major ones
+    auto coord_major = [this](auto *&tc, const auto *t, std::string name) {
+        if(!t) return;
+        using TableC = std::remove_reference_t<decltype(*tc)>;
+        tc = acquire<TableC>(name, [this,t,name](auto &x){ buildCoordMajor(x, *t, name); }, { ready(t) });
+    };
+    coord_major(pTMTwistC,  pTMTwist,  "tm_twist_cm");
+    coord_major(pTMFlipC,   pTMFlip,   "tm_flip_cm");
+    coord_major(pTMSliceC,  pTMSlice,  "tm_slice_cm");
+    coord_major(pTMCornerC, pTMCorner, "tm_corner_cm");
+    coord_major(pTMEdge4C,  pTMEdge4,  "tm_edge4_cm");
+    coord_major(pTMEdge8C,  pTMEdge8,  "tm_edge8_cm");
+    if((phases & TABLE_PH1) && option.flipslice) {
+        pTMFlipSliceC = acquire<NArray<uint32_t,N_FLIPSLICE,N_MOVE>>("tm_flipslice_cm", [this](auto &t){
+            buildFlipSliceTable(t, *pTMFlip, *pTMSlice, "tm_flipslice_cm"); },
+            { ready(pTMFlip), ready(pTMSlice) });
     }
     VPRINT("-- DONE.\n");
 }
 
-template<typename T>
-TableMove<T>::~TableMove()
+/*!
+ * @brief BFS from t[0][0] = 0 on a 2-D table t[c][x] by the threads of `pool`
+ * @details
+ *  - next(c,x,k) is the entry reached from (c,x) by the k-th move;
+ *  - self(c) is the bitmask of symmetries s with (c,x) ~ (c,conj(c,x,s)); 
+ *    equivalent entries are always visited together (self(c) = 1 if the 
+ *    table is not symmetry-reduced);
+ *  - `reversible`: whether (c,x) is reached back from next(c,x,k) by some 
+ *    move, which allows to sweep backward.
+ * Each depth is done in two passes over rows split among threads: first
+ * the table is only read and new entries are claimed in an atomic bitset; 
+ * then every thread writes depth+1 to the claimed entries of its own rows. 
+ * The result is therefore independent of the thread count and scheduling.
+ * The sweep goes forward (expanding the frontier) until the frontier 
+ * outnumbers unvisited entries, then backward (unvisited entries look for a
+ * neighbor in the frontier) if `reversible`.
+ */
+template<typename Table, typename Next, typename Self, typename Conj>
+static void bfs_table(Table &t, int n_move, Next&& next, Self&& self, Conj&& conj, 
+                      bool reversible, TaskPool &pool)
 {
-    delete pTMTwist;
-    delete pTMFlip;
-    delete pTMSlice;
-    delete pTMCorner;
-    delete pTMEdge4;
-    delete pTMEdge8;
+    using V = typename Table::value_type;
+    const V empty = (V)~0UL;
+    const size_t N2 = t.shape[1];
+    const size_t block = std::max<size_t>(1, t.shape[0] / (64 * pool.size()));
+    V *xs = t.flat();
+    std::fill_n(xs, t.size, empty);
+
+    std::unique_ptr<std::atomic<uint64_t>[]> seen(new std::atomic<uint64_t>[(t.size + 63) / 64]);
+    for(size_t i = 0; i < (t.size + 63) / 64; i++) seen[i].store(0, std::memory_order_relaxed);
+    auto is_seen = [&](size_t i) -> bool { 
+        return (seen[i >> 6].load(std::memory_order_relaxed) >> (i & 63)) & 1; 
+    };
+    auto claim = [&](size_t i) -> size_t {
+        uint64_t bit = uint64_t(1) << (i & 63);
+        return (seen[i >> 6].fetch_or(bit, std::memory_order_relaxed) & bit) ? 0 : 1;
+    };
+    // claim (c,x) and its equivalents, return the count of new entries
+    auto claim_all = [&](size_t c, size_t x) -> size_t {
+        size_t n = claim(c * N2 + x);
+        for(unsigned sm = self(c) >> 1, s = 1; sm; sm >>= 1, s++) {
+            if(sm & 1) n += claim(c * N2 + conj(c,x,s));
+        }
+        return n;
+    };
+    // write depth d to claimed entries
+    auto settle = [&](V d) {
+        pool.parallel_for(t.shape[0], block, [&](size_t c0, size_t c1) {
+            for(size_t i = c0 * N2; i < c1 * N2; i++) if(xs[i] == empty && is_seen(i)) xs[i] = d;
+        });
+    };
+
+    V depth = 0;
+    size_t count = claim_all(0,0), frontier = count;
+    settle(0);
+    VPRINT("\tdepth %2d: %10zu / %-10zu.\n", depth, count, t.size);
+    while(count < t.size)
+    {
+        if(frontier == 0) throw std::logic_error("unreachable entries in prunning table");
+        const bool backward = reversible && frontier > t.size - count;
+        std::atomic<size_t> found {0};
+        auto us = time_execution([&]() {
+            pool.parallel_for(t.shape[0], block, [&](size_t c0, size_t c1) {
+                size_t n = 0;
+                for(size_t c = c0; c < c1; c++)
+                for(size_t x = 0; x < N2; x++) {
+                    if(!backward && t[c][x] == depth) {
+                        for(int k = 0; k < n_move; k++) {
+                            auto [cc,xx] = next(c,x,k);
+                            if(!is_seen(cc * N2 + xx)) n += claim_all(cc,xx);
+                        }
+                    } else if(backward && !is_seen(c * N2 + x)) {
+                        for(int k = 0; k < n_move; k++) {
+                            auto [cc,xx] = next(c,x,k);
+                            if(t[cc][xx] == depth) { n += claim_all(c,x); break; }
+                        }
+                    }
+                }
+                found += n;
+            });
+            settle(depth + 1);
+        }).first;
+        frontier = found;
+        count += frontier;
+        depth++;
+        VPRINT("\tdepth %2d: %10zu / %-10zu (%s, %lld ms).\n", depth, count, t.size, 
+               backward ? "backward" : "forward", (long long)us.count() / 1000);
+    }
+}
+
+/* whether m^-1 undoes m on every coord of move table mt */
+template<typename MT>
+static bool is_reversible(const MT &mt)
+{
+    for(size_t m = 0; m < mt.shape[0]; m++) {
+        size_t m_inv = m / 3 * 3 + (2 - m % 3);
+        for(size_t i = 0; i < mt.shape[1]; i++) if(mt[m_inv][mt[m][i]] != i) return false;
+    }
+    return true;
 }
 
 template<typename T>
 template<typename Table, typename MT1, typename MT2>
 std::enable_if_t<Table::shape[0] == MT1::shape[1] && Table::shape[1] == MT2::shape[1]>
 TablePrunning<T>::buildPrunningTable(
-    Table &t, const MT1 &mt1, const MT2 &mt2, std::string filename)
+    Table &t, const MT1 &mt1, const MT2 &mt2, std::string name)
 {
     VPRINT("creating prunning table %s of shape (%zu,%zu):\n", 
-           filename.c_str(), mt1.shape[1], mt2.shape[1]);
-    std::fill_n(&t.data[0][0], t.size, (typename Table::value_type) ~0UL);
-    t[0][0] = 0;
+           name.c_str(), mt1.shape[1], mt2.shape[1]);
+    bfs_table(t, N_MOVE, 
+        [&](size_t i, size_t j, int m) { return std::make_pair<size_t,size_t>(mt1[m][i], mt2[m][j]); },
+        [](size_t) { return 1u; }, 
+        [](size_t, size_t x, int) { return x; },
+        is_reversible(mt1) && is_reversible(mt2), *pool_
+    );
+    VPRINT("done.\n");
+}
 
-    typename Table::value_type depth = 0;
-    size_t count = 1;
-    VPRINT("\tdepth %2d: %10zu / %-10zu.\n", depth, count, t.size);
-    while(count < t.size)
-    {
-        for(size_t i = 0; i < t.shape[0]; i++)
-        for(size_t j = 0; j < t.shape[1]; j++)
-        if(t[i][j] == depth) {
-            for(auto k = 0; k < N_MOVE; k++) {
-                auto ii = mt1[k][i], jj = mt2[k][j];
-                if(t[ii][jj] == (typename Table::value_type)~0UL) { t[ii][jj] = depth + 1; count++; }
-            } 
+template<typename T>
+template<typename Table, typename F1, typename F2>
+std::enable_if_t<Table::shape[1] == N_SYM_D4h>
+TableSymmetry<T>::buildConjTable(Table &t, F1&& coord2i, F2&& i2cc, std::string name)
+{
+    VPRINT("creating conjugation table %s of shape (%zu,%zu)... ", 
+           name.c_str(), t.shape[0], t.shape[1]);
+    for(size_t i = 0; i < t.shape[0]; i++) {
+        auto cc = i2cc(i);
+        for(size_t s = 0; s < t.shape[1]; s++) t[i][s] = coord2i(Sym::conj(s, cc));
+    }
+    VPRINT("done.\n");
+}
+
+template<typename T>
+template<typename Table, typename F1, typename F2>
+void TableSymmetry<T>::buildClassTable(
+    Table &t, size_t n_class, F1&& coord2i, F2&& i2cc, std::string name)
+{
+    using V = typename Table::value_type;
+    VPRINT("creating class table %s of size %zu... ", name.c_str(), t.size);
+    auto *xs = t.flat();
+    std::fill_n(xs, t.size, (V)~0UL);
+    size_t c = 0;
+    for(size_t i = 0; i < t.size; i++) {
+        if(xs[i] != (V)~0UL) continue;
+        // i is the representative of a new class; i2cc(i)^s^-1 are its members
+        auto cc = i2cc(i);
+        xs[i] = c << 4;
+        for(int s = 1; s < N_SYM_D4h; s++) {
+            size_t j = coord2i(Sym::conj(Sym::inv(s), cc));
+            if(xs[j] == (V)~0UL) xs[j] = (c << 4) | s;
         }
-        depth++;
-        VPRINT("\tdepth %2d: %10zu / %-10zu.\n", depth, count, t.size);
+        c++;
     }
-    if(filename != "") save_to(t, tdir/filename);
+    if(c != n_class) throw std::logic_error("unexpected count of symmetry classes");
     VPRINT("done.\n");
 }
 
 template<typename T>
-TablePrunning<T>::TablePrunning(std::string dir)
-:tdir(table_dir_fallback(dir))
+template<typename Table, typename ClassTable>
+void TableSymmetry<T>::buildRepTable(Table &t, const ClassTable &cls, std::string name)
 {
-    VPRINT("INIT PRUNNING TABLES -- \n");
-    pTPSliceFlip     = new NArray<T,N_SLICE,N_FLIP>;
-    pTPSliceTwist    = new NArray<T,N_SLICE,N_TWIST>;
-    pTPEdge4Edge8    = new NArray<T,N_EDGE4,N_EDGE8>;
-    pTPEdge4Corner   = new NArray<T,N_EDGE4,N_CORNER>;
-
-    if(!fs::exists(tdir/"tp_slicetwist.dat")) {
-        const auto &TM = SingletonTM<>::instance();
-        buildPrunningTable(*pTPSliceTwist, *TM.pTMSlice, *TM.pTMTwist, "tp_slicetwist.dat");
-        buildPrunningTable(*pTPSliceFlip, *TM.pTMSlice, *TM.pTMFlip, "tp_sliceflip.dat");
-        buildPrunningTable(*pTPEdge4Corner, *TM.pTMEdge4, *TM.pTMCorner, "tp_edge4corner.dat");
-        buildPrunningTable(*pTPEdge4Edge8, *TM.pTMEdge4, *TM.pTMEdge8, "tp_edge4edge8.dat");
-    } else {
-        load_from(*pTPSliceTwist, tdir/"tp_slicetwist.dat");
-        load_from(*pTPSliceFlip, tdir/"tp_sliceflip.dat");
-        load_from(*pTPEdge4Corner,tdir/"tp_edge4corner.dat");
-        load_from(*pTPEdge4Edge8, tdir/"tp_edge4edge8.dat");
+    VPRINT("creating representative table %s of size %zu... ", name.c_str(), t.size);
+    const auto *xs = cls.flat();
+    for(size_t i = 0; i < cls.size; i++) if((xs[i] & 15) == 0) t[xs[i] >> 4] = i;
+    VPRINT("done.\n");
+}
+
+template<typename T>
+template<typename Table, typename RepTable, typename F1, typename F2>
+void TableSymmetry<T>::buildSelfTable(
+    Table &t, const RepTable &rep, F1&& coord2i, F2&& i2cc, std::string name)
+{
+    VPRINT("creating self-symmetry table %s of size %zu... ", name.c_str(), t.size);
+    for(size_t c = 0; c < t.size; c++) {
+        auto cc = i2cc(rep[c]);
+        t[c] = 0;
+        for(int s = 0; s < N_SYM_D4h; s++) 
+            if(coord2i(Sym::conj(s, cc)) == rep[c]) t[c] |= 1 << s;
+    }
+    VPRINT("done.\n");
+}
+
+template<typename T>
+size_t TableSymmetry<T>::footprint(const TableOption &opt)
+{
+    return (opt.sym_ph1 ? sizeof(*pTSTwistConj) + sizeof(*pTSFlipSlice) 
+                        + sizeof(*pTSFlipSliceRep) + sizeof(*pTSFlipSliceSelf) : 0)
+         + (opt.sym_ph2 || opt.exact_ph2 ? sizeof(*pTSEdge8Conj) + sizeof(*pTSCorner) 
+                        + sizeof(*pTSCornerRep) + sizeof(*pTSCornerSelf) : 0)
+         + (opt.exact_ph2 ? sizeof(*pTSEdge4Conj) : 0);
+}
+
+template<typename T>
+TableSymmetry<T>::TableSymmetry(unsigned phases, const TableOption &opt)
+:TableBase(opt)
+{
+    VPRINT("INIT SYMMETRY TABLES -- \n");
+    auto twist2cc = [](size_t i) { 
+        auto cc = CubieCube::id; cc.co = Coord::twist2co(i); return cc; 
+    };
+    auto cc2twist = [](const CubieCube &cc) -> size_t { 
+        return Coord::co2twist(cc.co); 
+    };
+    auto flipslice2cc = [](size_t i) { 
+        auto cc = CubieCube::id; 
+        cc.ep = Coord::see2ep(i/N_FLIP,0,0), cc.eo = Coord::flip2eo(i%N_FLIP); 
+        return cc; 
+    };
+    auto cc2flipslice = [](const CubieCube &cc) -> size_t { 
+        return Coord::ep2slice(cc.ep) * N_FLIP + Coord::eo2flip(cc.eo); 
+    };
+    auto corner2cc = [](size_t i) { 
+        auto cc = CubieCube::id; cc.cp = Coord::corner2cp(i); return cc; 
+    };
+    auto cc2corner = [](const CubieCube &cc) -> size_t { 
+        return Coord::cp2corner(cc.cp); 
+    };
+    // the sets of tables held; twistconj and the corner classes serve both a
+    // phase and the optimal solver
+    const bool sym_ph1 = (phases & TABLE_PH1) && option.sym_ph1;
+    const bool sym_ph2 = (phases & TABLE_PH2) && (option.sym_ph2 || option.exact_ph2);
+    const bool optimal = (phases & TABLE_OPT) != 0;
+    if(sym_ph1 || optimal) {
+        pTSTwistConj     = acquire<NArray<T,N_TWIST,N_SYM_D4h>>("ts_twistconj", [=](auto &t){
+            buildConjTable(t, cc2twist, twist2cc, "ts_twistconj"); });
+    }
+    if(sym_ph1) {
+        pTSFlipSlice     = acquire<NArray<uint32_t,N_SLICE,N_FLIP>>("ts_flipslice", [=](auto &t){
+            buildClassTable(t, EQ_FLIPSLICE, cc2flipslice, flipslice2cc, "ts_flipslice"); });
+        pTSFlipSliceRep  = acquire<NArray<uint32_t,EQ_FLIPSLICE>>("ts_flipslicerep", [=](auto &t){
+            buildRepTable(t, *pTSFlipSlice, "ts_flipslicerep"); }, {ready(pTSFlipSlice)});
+        pTSFlipSliceSelf = acquire<NArray<uint16_t,EQ_FLIPSLICE>>("ts_flipsliceself", [=](auto &t){
+            buildSelfTable(t, *pTSFlipSliceRep, cc2flipslice, flipslice2cc, "ts_flipsliceself"); },
+            {ready(pTSFlipSliceRep)});
+    }
+
+    if(sym_ph2) {
+        auto edge82cc = [](size_t i) { 
+            auto cc = CubieCube::id; cc.ep = Coord::see2ep(0,0,i); return cc; 
+        };
+        auto cc2edge8 = [](const CubieCube &cc) -> size_t { 
+            return Coord::ep2edge8(cc.ep); 
+        };
+        pTSEdge8Conj  = acquire<NArray<T,N_EDGE8,N_SYM_D4h>>("ts_edge8conj", [=](auto &t){
+            buildConjTable(t, cc2edge8, edge82cc, "ts_edge8conj"); });
+    }
+    if(sym_ph2 || optimal) {
+        pTSCorner     = acquire<NArray<uint16_t,N_CORNER>>("ts_corner", [=](auto &t){
+            buildClassTable(t, EQ_CORNER, cc2corner, corner2cc, "ts_corner"); });
+        pTSCornerRep  = acquire<NArray<uint16_t,EQ_CORNER>>("ts_cornerrep", [=](auto &t){
+            buildRepTable(t, *pTSCorner, "ts_cornerrep"); }, {ready(pTSCorner)});
+        pTSCornerSelf = acquire<NArray<uint16_t,EQ_CORNER>>("ts_cornerself", [=](auto &t){
+            buildSelfTable(t, *pTSCornerRep, cc2corner, corner2cc, "ts_cornerself"); },
+            {ready(pTSCornerRep)});
+    }
+    if((phases & TABLE_PH2) && option.exact_ph2) {
+        auto edge42cc = [](size_t i) { 
+            auto cc = CubieCube::id; cc.ep = Coord::see2ep(0,i,0); return cc; 
+        };
+        auto cc2edge4 = [](const CubieCube &cc) -> size_t { 
+            return Coord::ep2edge4(cc.ep); 
+        };
+        pTSEdge4Conj  = acquire<NArray<T,N_EDGE4,N_SYM_D4h>>("ts_edge4conj", [=](auto &t){
+            buildConjTable(t, cc2edge4, edge42cc, "ts_edge4conj"); });
     }
     VPRINT("-- DONE.\n");
 }
 
+/* the pending singleton of table set S holding the tables of `phases` */
+template<typename S>
+static S& pending_set(unsigned phases)
+{
+    switch(phases) {
+        case TABLE_PH1: return Singleton<S,TABLE_PH1>::pending();
+        case TABLE_PH2: return Singleton<S,TABLE_PH2>::pending();
+        case TABLE_OPT: return Singleton<S,TABLE_OPT>::pending();
+        default:        return Singleton<S,TABLE_ALL>::pending();
+    }
+}
+
+/* pack the table of distances into that of distances mod 3 */
+template<typename Packed, typename Table>
+static void pack_mod3(Packed &p, const Table &t)
+{
+    static_assert(Packed::size == Table::size);
+    const auto *xs = t.flat();
+    for(size_t i = 0; i < t.size; i++) p.set(i, xs[i] % 3);
+}
+
 template<typename T>
-TablePrunning<T>::~TablePrunning()
+template<typename Table, typename TM, typename TS>
+void TablePrunning<T>::buildFlipSliceTwistTable(
+    Table &packed, const TM &tm, const TS &ts, std::string name)
 {
-    delete pTPSliceFlip;
-    delete pTPSliceTwist;
-    delete pTPEdge4Edge8;
-    delete pTPEdge4Corner;
+    VPRINT("creating prunning table %s of shape (%zu,%zu):\n", 
+           name.c_str(), packed.shape[0], packed.shape[1]);
+    auto pt = std::unique_ptr<NArray<T,EQ_FLIPSLICE,N_TWIST>>(new NArray<T,EQ_FLIPSLICE,N_TWIST>);
+    auto &t = *pt;
+    const auto &mtSlice = *tm.pTMSlice, &mtFlip = *tm.pTMFlip, &mtTwist = *tm.pTMTwist;
+    const auto &cls = *ts.pTSFlipSlice, &rep = *ts.pTSFlipSliceRep, &self = *ts.pTSFlipSliceSelf;
+    const auto &conj = *ts.pTSTwistConj;
+    bfs_table(t, N_MOVE, 
+        [&](size_t c, size_t x, int m) {
+            auto cs = cls[mtSlice[m][rep[c]/N_FLIP]][mtFlip[m][rep[c]%N_FLIP]];
+            return std::make_pair<size_t,size_t>(cs >> 4, conj[mtTwist[m][x]][cs & 15]);
+        }, 
+        [&](size_t c) { return self[c]; }, 
+        [&](size_t, size_t x, int s) { return conj[x][s]; },
+        true, *pool_
+    );
+    pack_mod3(packed, t);
+    VPRINT("done.\n");
+}
+
+/* the moves of phase 2 (see TwoPhaseSolver::EM1) */
+static constexpr TurnMove Ph2Move[10] = { Ux1,Ux2,Ux3,Rx2,Fx2,Dx1,Dx2,Dx3,Lx2,Bx2 };
+
+template<typename T>
+template<typename Table, typename TM, typename TS>
+void TablePrunning<T>::buildCornerEdge8Table(
+    Table &packed, const TM &tm, const TS &ts, std::string name)
+{
+    VPRINT("creating prunning table %s of shape (%zu,%zu):\n", 
+           name.c_str(), packed.shape[0], packed.shape[1]);
+    auto pt = std::unique_ptr<NArray<T,EQ_CORNER,N_EDGE8>>(new NArray<T,EQ_CORNER,N_EDGE8>);
+    auto &t = *pt;
+    const auto &mtCorner = *tm.pTMCorner, &mtEdge8 = *tm.pTMEdge8;
+    const auto &cls = *ts.pTSCorner, &rep = *ts.pTSCornerRep, &self = *ts.pTSCornerSelf;
+    const auto &conj = *ts.pTSEdge8Conj;
+    bfs_table(t, std::size(Ph2Move), 
+        [&](size_t c, size_t x, int k) {
+            auto cs = cls[mtCorner[Ph2Move[k]][rep[c]]];
+            return std::make_pair<size_t,size_t>(cs >> 4, conj[mtEdge8[Ph2Move[k]][x]][cs & 15]);
+        }, 
+        [&](size_t c) { return self[c]; }, 
+        [&](size_t, size_t x, int s) { return conj[x][s]; },
+        true, *pool_
+    );
+    pack_mod3(packed, t);
+    VPRINT("done.\n");
+}
+
+template<typename T>
+template<typename Table, typename TM, typename TS>
+void TablePrunning<T>::buildCornerEdge8Edge4Table(
+    Table &packed, const TM &tm, const TS &ts, std::string name)
+{
+    VPRINT("creating prunning table %s of shape (%zu,%zu,%zu):\n", 
+           name.c_str(), packed.shape[0], packed.shape[1], packed.shape[2]);
+    // (edge8, edge4) are flattened to x = edge8*N_EDGE4/2+edge4/2: of the
+    // permutation ranks 2i and 2i+1 (one even, one odd) only one is reached,
+    // of the parity of corner x edge8
+    using Flat = NArray<T,EQ_CORNER,N_EDGE8*N_EDGE4/2>;
+    auto pt = std::unique_ptr<Flat>(new Flat);
+    auto &t = *pt;
+    const auto &mtCorner = *tm.pTMCorner, &mtEdge8 = *tm.pTMEdge8, &mtEdge4 = *tm.pTMEdge4;
+    const auto &cls = *ts.pTSCorner, &rep = *ts.pTSCornerRep, &self = *ts.pTSCornerSelf;
+    const auto &conj8 = *ts.pTSEdge8Conj, &conj4 = *ts.pTSEdge4Conj;
+    std::vector<uint8_t> odd8(N_EDGE8), odd4(N_EDGE4);   // the parity of ranks
+    for(size_t i = 0; i < N_EDGE8; i++) odd8[i] = !Perm<8>::fromRank(i).parity();
+    for(size_t i = 0; i < N_EDGE4; i++) odd4[i] = !Perm<4>::fromRank(i).parity();
+    // (edge8, edge4) of x in row c
+    auto unflat = [&](size_t c, size_t x) {
+        size_t e8 = x / (N_EDGE4/2), e4 = x % (N_EDGE4/2) * 2;
+        return std::make_pair(e8, e4 + (odd4[e4] != (odd8[rep[c]] != odd8[e8])));
+    };
+    auto flat = [](size_t e8, size_t e4) { return e8 * (N_EDGE4/2) + e4 / 2; };
+    bfs_table(t, std::size(Ph2Move), 
+        [&](size_t c, size_t x, int k) {
+            auto m = Ph2Move[k];
+            auto [e8, e4] = unflat(c, x);
+            auto cs = cls[mtCorner[m][rep[c]]];
+            auto s = cs & 15;
+            return std::make_pair<size_t,size_t>(cs >> 4, flat(conj8[mtEdge8[m][e8]][s], conj4[mtEdge4[m][e4]][s]));
+        }, 
+        [&](size_t c) { return self[c]; }, 
+        [&](size_t c, size_t x, int s) { 
+            auto [e8, e4] = unflat(c, x);
+            return flat(conj8[e8][s], conj4[e4][s]); 
+        },
+        true, *pool_
+    );
+    pack_mod3(packed, t);
+    VPRINT("done.\n");
+}
+
+template<typename T>
+template<typename Table, typename TM, typename TS>
+void TablePrunning<T>::buildCornerTwistTable(
+    Table &packed, const TM &tm1, const TM &tm2, const TS &ts, std::string name)
+{
+    VPRINT("creating prunning table %s of shape (%zu,%zu):\n", 
+           name.c_str(), packed.shape[0], packed.shape[1]);
+    auto pt = std::unique_ptr<NArray<T,EQ_CORNER,N_TWIST>>(new NArray<T,EQ_CORNER,N_TWIST>);
+    auto &t = *pt;
+    const auto &mtCorner = *tm2.pTMCorner, &mtTwist = *tm1.pTMTwist;
+    const auto &cls = *ts.pTSCorner, &rep = *ts.pTSCornerRep, &self = *ts.pTSCornerSelf;
+    const auto &conj = *ts.pTSTwistConj;
+    bfs_table(t, N_MOVE, 
+        [&](size_t c, size_t x, int m) {
+            auto cs = cls[mtCorner[m][rep[c]]];
+            return std::make_pair<size_t,size_t>(cs >> 4, conj[mtTwist[m][x]][cs & 15]);
+        }, 
+        [&](size_t c) { return self[c]; }, 
+        [&](size_t, size_t x, int s) { return conj[x][s]; },
+        true, *pool_
+    );
+    pack_mod3(packed, t);
+    VPRINT("done.\n");
+}
+
+template<typename T>
+size_t TablePrunning<T>::footprint(const TableOption &opt)
+{
+    return sizeof(*pTPTwistSlice) + sizeof(*pTPFlipSlice) 
+         + sizeof(*pTPCornerEdge4) + sizeof(*pTPEdge8Edge4)
+         + (opt.sym_ph1 ? sizeof(*pTPFlipSliceTwist) : 0)
+         + (opt.sym_ph2 && !opt.exact_ph2 ? sizeof(*pTPCornerEdge8) : 0)
+         + (opt.exact_ph2 ? sizeof(*pTPCornerEdge8Edge4) : 0);
+}
+
+template<typename T>
+TablePrunning<T>::TablePrunning(unsigned phases, const TableOption &opt)
+:TableBase(opt)
+{
+    VPRINT("INIT PRUNNING TABLES -- \n");
+    // tables are scheduled after those they derive from, which may be pending
+    const auto *tm = &pending_set<TableMove<>>(phases);
+    const auto *ts = &pending_set<TableSymmetry<>>(phases);
+    if(phases & TABLE_PH1) {
+        pTPTwistSlice  = acquire<NArray<T,N_TWIST,N_SLICE>>("tp_twistslice", [=](auto &t){
+            buildPrunningTable(t, *tm->pTMTwist, *tm->pTMSlice, "tp_twistslice"); }, 
+            {tm->ready(tm->pTMSlice), tm->ready(tm->pTMTwist)});
+        pTPFlipSlice   = acquire<NArray<T,N_FLIP,N_SLICE>>("tp_flipslice", [=](auto &t){
+            buildPrunningTable(t, *tm->pTMFlip, *tm->pTMSlice, "tp_flipslice"); }, 
+            {tm->ready(tm->pTMSlice), tm->ready(tm->pTMFlip)});
+        if(option.sym_ph1) {
+            pTPFlipSliceTwist = acquire<PackedNArray<EQ_FLIPSLICE,N_TWIST>>("tp_flipslicetwist_mod3", [=](auto &t){
+                buildFlipSliceTwistTable(t, *tm, *ts, "tp_flipslicetwist_mod3"); }, 
+                {tm->ready(tm->pTMSlice), tm->ready(tm->pTMFlip), tm->ready(tm->pTMTwist),
+                 ts->ready(ts->pTSFlipSlice), ts->ready(ts->pTSFlipSliceRep), 
+                 ts->ready(ts->pTSFlipSliceSelf), ts->ready(ts->pTSTwistConj)});
+        }
+    }
+    if(phases & TABLE_PH2) {
+        pTPCornerEdge4 = acquire<NArray<T,N_CORNER,N_EDGE4>>("tp_corneredge4", [=](auto &t){
+            buildPrunningTable(t, *tm->pTMCorner, *tm->pTMEdge4, "tp_corneredge4"); }, 
+            {tm->ready(tm->pTMEdge4), tm->ready(tm->pTMCorner)});
+        pTPEdge8Edge4  = acquire<NArray<T,N_EDGE8,N_EDGE4>>("tp_edge8edge4", [=](auto &t){
+            buildPrunningTable(t, *tm->pTMEdge8, *tm->pTMEdge4, "tp_edge8edge4"); }, 
+            {tm->ready(tm->pTMEdge4), tm->ready(tm->pTMEdge8)});
+        if(option.exact_ph2) {
+            pTPCornerEdge8Edge4 = acquire<PackedNArray<EQ_CORNER,N_EDGE8,N_EDGE4/2>>("tp_corneredge8edge4_mod3", [=](auto &t){
+                buildCornerEdge8Edge4Table(t, *tm, *ts, "tp_corneredge8edge4_mod3"); }, 
+                {tm->ready(tm->pTMCorner), tm->ready(tm->pTMEdge8), tm->ready(tm->pTMEdge4),
+                 ts->ready(ts->pTSCorner), ts->ready(ts->pTSCornerRep), ts->ready(ts->pTSCornerSelf), 
+                 ts->ready(ts->pTSEdge8Conj), ts->ready(ts->pTSEdge4Conj)});
+        } else if(option.sym_ph2) {
+            pTPCornerEdge8 = acquire<PackedNArray<EQ_CORNER,N_EDGE8>>("tp_corneredge8_mod3", [=](auto &t){
+                buildCornerEdge8Table(t, *tm, *ts, "tp_corneredge8_mod3"); }, 
+                {tm->ready(tm->pTMCorner), tm->ready(tm->pTMEdge8),
+                 ts->ready(ts->pTSCorner), ts->ready(ts->pTSCornerRep), 
+                 ts->ready(ts->pTSCornerSelf), ts->ready(ts->pTSEdge8Conj)});
+        }
+    }
+    if(phases & TABLE_OPT) {
+        const auto *tm1 = &pending_set<TableMove<>>(TABLE_PH1), *tm2 = &pending_set<TableMove<>>(TABLE_PH2);
+        pTPCornerTwist = acquire<PackedNArray<EQ_CORNER,N_TWIST>>("tp_cornertwist_mod3", [=](auto &t){
+            buildCornerTwistTable(t, *tm1, *tm2, *ts, "tp_cornertwist_mod3"); }, 
+            {tm1->ready(tm1->pTMTwist), tm2->ready(tm2->pTMCorner),
+             ts->ready(ts->pTSCorner), ts->ready(ts->pTSCornerRep), 
+             ts->ready(ts->pTSCornerSelf), ts->ready(ts->pTSTwistConj)});
+    }
+    VPRINT("-- DONE.\n");
+}
+
+/* the bijective finalizer of splitmix64 */
+static uint64_t mix64(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t TableEndgame::key(const CubieCube &cc)
+{
+    // corners (40 bits) and edges (60 bits) packed as they are, no ranks
+    uint64_t c = 0, e = 0;
+    for(int i = 0; i < 8; i++) c = (c << 5) | (cc.cp[i] << 2) | cc.co[i];
+    for(int i = 0; i < 12; i++) e = (e << 5) | (cc.ep[i] << 1) | cc.eo[i];
+    return mix64(e ^ mix64(c)) & ~uint64_t(7);
+}
+
+int TableEndgame::distance(const CubieCube &cc) const
+{
+    if(!pTEBall) return -1;
+    const uint64_t k = key(cc);
+    const uint64_t *end = pTEBall + N_BALL[depth];
+    const uint64_t *it = std::lower_bound(pTEBall, end, k);
+    return it != end && (*it & ~uint64_t(7)) == k ? int(*it & 7) : -1;
+}
+
+/* push the keys of cubes cc*m1*...*mk (k <= togo) with their distance d+k, 
+ * over the canonical maneuvers: a face is not turned twice in a row, and 
+ * of two opposite (commuting) faces, U/R/F goes first */
+static void push_ball(std::vector<uint64_t> &keys, const CubieCube &cc, int last, unsigned d, unsigned togo)
+{
+    keys.push_back(TableEndgame::key(cc) | d);
+    if(togo == 0) return;
+    for(int m = 0; m < N_MOVE; m++) {
+        if(last >= 0 && (m / 3 == last / 3 || m / 3 + 3 == last / 3)) continue;
+        push_ball(keys, cc * ElementaryMove[m], m, d + 1, togo - 1);
+    }
+}
+
+template<typename Table>
+void TableEndgame::buildBallTable(Table &t, unsigned depth, std::string name)
+{
+    VPRINT("creating endgame table %s of size %zu... ", name.c_str(), t.size);
+    // the subtrees of first moves are enumerated in parallel
+    std::vector<std::vector<uint64_t>> parts(N_MOVE);
+    pool_->parallel_for(N_MOVE, 1, [&](size_t m0, size_t m1) {
+        for(size_t m = m0; m < m1; m++) push_ball(parts[m], ElementaryMove[m], m, 1, depth - 1);
+    });
+    std::vector<uint64_t> keys { key(CubieCube::id) };
+    for(auto &p: parts) keys.insert(keys.end(), p.begin(), p.end()), std::vector<uint64_t>().swap(p);
+    // of the keys of one cube (or colliding cubes), the smallest distance is first
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end(), [](uint64_t a, uint64_t b) { 
+        return (a >> 3) == (b >> 3); 
+    }), keys.end());
+    if(keys.size() > t.size) throw std::logic_error("unexpected count of cubes in endgame table");
+    auto *xs = t.flat();
+    std::copy(keys.begin(), keys.end(), xs);
+    std::fill(xs + keys.size(), xs + t.size, ~uint64_t(0));
+    VPRINT("done (%zu collisions).\n", t.size - keys.size());
+}
+
+size_t TableEndgame::footprint(const TableOption &opt)
+{
+    return opt.endgame ? N_BALL[std::min(opt.endgame, 7u)] * sizeof(uint64_t) : 0;
+}
+
+TableEndgame::TableEndgame(unsigned, const TableOption &opt)
+:TableBase(opt), depth(std::min(opt.endgame, 7u))
+{
+    if(depth == 0) return;
+    VPRINT("INIT ENDGAME TABLES -- \n");
+    // the table type is fixed by its depth
+    auto ball = [this](auto d) {
+        using Table = NArray<uint64_t,N_BALL[d]>;
+        auto name = "te_ball" + std::to_string(d);
+        pTEBall = acquire<Table>(name, [this,d,name](auto &t){ buildBallTable(t, d, name); })->flat();
+    };
+    switch(depth) {
+        case 1: ball(std::integral_constant<unsigned,1>{}); break;
+        case 2: ball(std::integral_constant<unsigned,2>{}); break;
+        case 3: ball(std::integral_constant<unsigned,3>{}); break;
+        case 4: ball(std::integral_constant<unsigned,4>{}); break;
+        case 5: ball(std::integral_constant<unsigned,5>{}); break;
+        case 6: ball(std::integral_constant<unsigned,6>{}); break;
+        default: ball(std::integral_constant<unsigned,7>{}); break;
+    }
+    VPRINT("-- DONE.\n");
 }
 
 template struct TableMove<>;
+template struct TableSymmetry<>;
 template struct TablePrunning<>;
\ No newline at end of file
@@ -2,23 +2,141 @@
 #include "def.h"
 #include "help.hpp"
 #include "coord.hh"
+#include "parallel.hpp"
+#include "storage.hh"
 
 #include <fstream>
 #include <filesystem>
 #include <type_traits>
 #include <limits>
+#include <map>
+#include <memory>
+#include <vector>
 
 typedef uint16_t    default_mt_value_t;
 typedef uint8_t     default_pt_value_t;
 
 template<typename T> struct TableMove;
+template<typename T> struct TableSymmetry;
 template<typename T> struct TablePrunning;
+struct TableEndgame;
 
-/* dump / load Tables */
-template <typename Table> void save_to(const Table &table, std::filesystem::path path);
-template <typename Table> void load_from(Table &table, std::filesystem::path path);
+/*!
+ * @brief Options on how tables are located and loaded
+ * @details
+ * The default values are read from environment variables once:
+ *  - CUBE_TABLE_DIR:   the table directory (default: system cache directory);
+ *  - CUBE_TABLE_MMAP:  "1" => map the cached table bundle read-only instead 
+ *                      of copying tables into heap memory;
+ *  - CUBE_TABLE_VERIFY: "1" => verify the checksums of mapped tables too,
+ *                      which reads all their pages at once;
+ *  - CUBE_TABLE_TIER:  "minimal" / "standard" / "large" / "exact" => set 
+ *                      all of `sym_ph1`, `sym_ph2` and `exact_ph2`, to 
+ *                      (0,0,0), (1,0,0), (1,1,0) and (1,1,1) respectively; 
+ *                      the options below may refine them;
+ *  - CUBE_TABLE_SYM_PH2: "1" => use the (optional) symmetry-reduced corner
+ *                      x edge8 table in phase 2;
+ *  - CUBE_TABLE_FLIPSLICE: "1" => use the (optional) combined flipslice 
+ *                      move table in phase 1;
+ *  - CUBE_TABLE_EXACT_PH2: "1" => use the (optional) exact phase 2 table;
+ *  - CUBE_TABLE_ENDGAME: the depth of the (optional) endgame table (0, the 
+ *                      default, to 7);
+ *  - CUBE_TABLE_THREADS: the count of threads to build tables (default: 
+ *                      hardware concurrency);
+ *  - CUBE_TABLE_PAGES: "thp" / "hugetlb" => put tables in transparent / 
+ *                      explicit huge pages (see MemoryOption);
+ *  - CUBE_TABLE_NUMA:  "interleave" => interleave tables over NUMA nodes;
+ *  - CUBE_TABLE_MLOCK: "1" => lock tables in memory.
+ * With `mmap`, table pointers point straight into the mapping; pages are
+ * shared by all processes through the page cache.
+ */
+struct TableOption
+{
+    std::string dir     = "";
+    bool        mmap    = false;
+    bool        verify  = false;    // the checksums of mapped tables
+    bool        sym_ph1 = true;
+    bool        sym_ph2 = false;
+    bool        flipslice = false;
+    bool        exact_ph2 = false;
+    unsigned    endgame = 0;
+    unsigned    threads = 0;
+    MemoryOption memory;
+};
+
+/* the process-wide options, used by table singletons on construction */
+TableOption& table_option();
+
+/* the search phases whose tables a table set holds, so that the tables of
+ * each phase are loaded independently; TABLE_OPT holds the tables only the
+ * optimal solver uses (see OptimalSolver), loaded on its first solve */
+enum TablePhase : unsigned { TABLE_PH1 = 1, TABLE_PH2 = 2, TABLE_ALL = 3, TABLE_OPT = 4 };
+
+/*!
+ * @brief The common part of table sets
+ * @details The memory that table pointers refer to (heap or file mapping)
+ * is owned by `storage_` and released together with the table set.
+ * Tables are cached as sections of one TableBundle (`bundle_file` in 
+ * `tdir`), shared by all table sets; the tables built by a set are added
+ * to the bundle once the set is complete (see `wait`). Libraries built 
+ * with EMBED_TABLES carry a bundle as read-only data, whose tables are 
+ * used in place, before looking at the file system.
+ * Tables are built under an advisory lock on `lock_file` in `tdir`, held 
+ * from the first missing table until the set is published, so that among 
+ * processes sharing `tdir` (and starting at once) one builds while the 
+ * others wait and then load its bundle; the lock is shared by all table 
+ * sets of the process, and released by the OS if it dies (leaving the old
+ * bundle intact, see TableBundle::publish).
+ * Missing tables are built as tasks of a TaskPool shared by all table sets
+ * under construction, so that independent tables are built concurrently 
+ * and each one starts as soon as the tables it is derived from are done,
+ * whichever set they belong to (see `ready`).
+ */
+struct TableBase
+{
+    TableBase(const TableOption &opt);
+
+    /* get the table `name`: load (or map) it if cached and valid; otherwise 
+     * allocate it and schedule `build(table)` after the tasks `deps`.
+     * (precondition) `build` only refers to data outliving the table set */
+    template<typename Table, typename Build>
+    Table* acquire(std::string name, Build &&build, std::vector<TaskPool::Handle> deps = {});
+
+    /* the task building `table` (null if it was loaded) */
+    TaskPool::Handle ready(const void *table) const;
+
+    /* the backing of tables obtained */
+    MemoryBacking backing() const;
+
+    /* wait for all tables of the set to be built, rethrow build errors; 
+     * then publish the built tables to the bundle (best effort) and release
+     * the lock of `tdir` */
+    void wait();
+
+    /* directory to save tables */
+    const std::filesystem::path tdir;
+
+    static constexpr const char *bundle_file = "tables.bin";
+    static constexpr const char *lock_file = "tables.lock";
 
-template<class T>
+    const TableOption option;
+
+protected:
+    /* (re)open the bundle in `tdir` */
+    void open_bundle();
+
+    std::vector<std::shared_ptr<void>> storage_;
+    std::vector<const TableMemory*> memory_;    // anonymous memory in storage_
+    MemoryBacking mapped_;                      // tables mapped in place
+    std::shared_ptr<TableBundle> bundle_;     // opened on demand
+    std::vector<TableBundle::Section> built_;
+    std::map<const void*,TaskPool::Handle> tasks_;
+    std::shared_ptr<TaskPool> pool_;    // alive while tables are being built
+    std::shared_ptr<FileLock> lock_;    // held while tables are being built
+    bool locked_ = false;               // whether the lock was taken once
+};
+
+template<class T, unsigned Phases=TABLE_ALL>
 class Singleton
 {
 public:
@@ -27,8 +145,15 @@ public:
     Singleton& operator=(const Singleton&) = delete;
     Singleton& operator=(Singleton&&) = delete;
     
+    /* the instance, once all its tables are ready */
     static T& instance() {
-        static T obj {};
+        static T &obj = [](T &x) -> T& { x.wait(); return x; }(pending());
+        return obj;
+    }
+
+    /* the instance, whose tables may still be under construction */
+    static T& pending() {
+        static T obj { Phases };
         return obj;
     }
 protected:
@@ -36,11 +161,16 @@ protected:
     ~Singleton() = default;
 };
 
-template<typename T=default_mt_value_t>
-using SingletonTM = Singleton<TableMove<T>>;
+template<unsigned Phases=TABLE_ALL, typename T=default_mt_value_t>
+using SingletonTM = Singleton<TableMove<T>,Phases>;
 
-template<typename T=default_pt_value_t>
-using SingletonTP = Singleton<TablePrunning<T>>;
+template<unsigned Phases=TABLE_ALL, typename T=default_mt_value_t>
+using SingletonTS = Singleton<TableSymmetry<T>,Phases>;
+
+template<unsigned Phases=TABLE_ALL, typename T=default_pt_value_t>
+using SingletonTP = Singleton<TablePrunning<T>,Phases>;
+
+using SingletonTE = Singleton<TableEndgame>;
 
 /*!
  * @brief The table to cache move transforms on Coord
@@ -50,33 +180,124 @@ using SingletonTP = Singleton<TablePrunning<T>>;
  * Therefore, mt can be decomposited into the product of six components 
  * mt_i: Move * Coord_i -> Coord_i; that dramatically reduces the count of 
  * table items.  
+ * Twist/flip/slice tables are of phase 1, corner/edge4/edge8 of phase 2; 
+ * the tables of phases not in `phases` are nullptr.
+ * Each table comes in two layouts: 
+ *  - move-major, t[m][x], which the tables derived from it are built on;
+ *  - coord-major, tc[x][m] (suffix C), whose row holds all moves of one 
+ *    coord padded to whole cache lines (`row`), so that expanding a search
+ *    node touches one cache line per table instead of one per move.
+ * The optional FlipSlice table (only created with `TableOption::flipslice`,
+ * ~73MB) moves flip and slice at once on flipslice = slice*N_FLIP+flip, 
+ * the index of the phase 1 class table (see TableSymmetry), coord-major.
  * @note edge4/edge8 move tables work in phase 2 only. 
  */
 template<typename T=default_mt_value_t>
-struct TableMove
+struct TableMove: TableBase
 {
     static_assert(std::is_integral<T>::value);
     static_assert(std::numeric_limits<T>::digits >= 16);
 
     using value_t = T;
-    TableMove(std::string dir="");
+
+    /* the row length of coord-major tables: N_MOVE padded to cache lines */
+    static constexpr size_t row = (N_MOVE * sizeof(T) + 63) / 64 * 64 / sizeof(T);
+
+    TableMove(unsigned phases=TABLE_ALL, const TableOption &opt=table_option());
     TableMove(const TableMove &) = delete;
-    ~TableMove();
     TableMove& operator=(const TableMove &) = delete;
+
+    /* the bytes of tables created with `opt` (for all phases) */
+    static size_t footprint(const TableOption &opt);
     
     template<typename Table, typename F1, typename F2>
     std::enable_if_t<Table::shape[0] == N_MOVE, void> 
-    buildMoveTable(Table &t, F1&& coord2i, F2&& i2coord, std::string filename="");
+    buildMoveTable(Table &t, F1&& coord2i, F2&& i2coord, std::string name="");
 
-    /* directory to save tables */
-    const std::filesystem::path tdir;
+    /* t[slice*N_FLIP+flip][m] = slice'*N_FLIP+flip', moved by flip/slice tables */
+    template<typename Table, typename TF, typename TS>
+    void buildFlipSliceTable(Table &t, const TF &flip, const TS &slice, std::string name);
+
+    /* tc[x][m] = t[m][x], padded with 0 */
+    template<typename TableC, typename Table>
+    std::enable_if_t<TableC::shape[0] == Table::shape[1] && TableC::shape[1] == row> 
+    buildCoordMajor(TableC &tc, const Table &t, std::string name);
 
-    NArray<T,N_MOVE,N_TWIST>   *pTMTwist;
-    NArray<T,N_MOVE,N_FLIP>    *pTMFlip;
-    NArray<T,N_MOVE,N_SLICE>   *pTMSlice;
-    NArray<T,N_MOVE,N_CORNER>  *pTMCorner;
-    NArray<T,N_MOVE,N_EDGE4>   *pTMEdge4;
-    NArray<T,N_MOVE,N_EDGE8>   *pTMEdge8;
+    NArray<T,N_MOVE,N_TWIST>   *pTMTwist    = nullptr;
+    NArray<T,N_MOVE,N_FLIP>    *pTMFlip     = nullptr;
+    NArray<T,N_MOVE,N_SLICE>   *pTMSlice    = nullptr;
+    NArray<T,N_MOVE,N_CORNER>  *pTMCorner   = nullptr;
+    NArray<T,N_MOVE,N_EDGE4>   *pTMEdge4    = nullptr;
+    NArray<T,N_MOVE,N_EDGE8>   *pTMEdge8    = nullptr;
+
+    NArray<T,N_TWIST,row>      *pTMTwistC   = nullptr;
+    NArray<T,N_FLIP,row>       *pTMFlipC    = nullptr;
+    NArray<T,N_SLICE,row>      *pTMSliceC   = nullptr;
+    NArray<T,N_CORNER,row>     *pTMCornerC  = nullptr;
+    NArray<T,N_EDGE4,row>      *pTMEdge4C   = nullptr;
+    NArray<T,N_EDGE8,row>      *pTMEdge8C   = nullptr;
+
+    NArray<uint32_t,N_FLIPSLICE,N_MOVE> *pTMFlipSliceC = nullptr; // optional
+};
+
+/*!
+ * @brief The tables to reduce coords by D4h symmetries
+ * @details
+ * Since d(s*x*s^-1) = d(x) for s in D4h (see Sym in @ref symmetry.hh), a 
+ * prunning table only needs one entry per symmetry class. A coord `a` is 
+ * reduced to its class `c` and symmetry `s` such that s*a*s^-1 = rep(c);
+ * the other coords `x` of cube then enter the table conjugated by `s`:
+ *   pt(a,x) = pt_sym(c, x^s),  x^s := s*x*s^-1.
+ * Tables:
+ *  - TwistConj[twist][s]       := twist^s;
+ *  - FlipSlice[slice][flip]    := (c << 4) | s;  (flipslice = slice*N_FLIP+flip)
+ *  - FlipSliceRep[c]           := flipslice of representative;
+ *  - FlipSliceSelf[c]          := bitmask of s such that rep(c)^s = rep(c).
+ * of phase 1, which are only created with `TableOption::sym_ph1`, and 
+ * similarly Edge8Conj, Corner, CornerRep, CornerSelf of phase 2, which are
+ * only created with `TableOption::sym_ph2` or `exact_ph2`, and Edge4Conj,
+ * only created with `exact_ph2`; TwistConj, Corner, CornerRep, CornerSelf
+ * are also created for TABLE_OPT. Tables not created (or of phases not in 
+ * `phases`) are nullptr.
+ */
+template<typename T=default_mt_value_t>
+struct TableSymmetry: TableBase
+{
+    using value_t = T;
+    TableSymmetry(unsigned phases=TABLE_ALL, const TableOption &opt=table_option());
+    TableSymmetry(const TableSymmetry &) = delete;
+    TableSymmetry& operator=(const TableSymmetry &) = delete;
+
+    /* the bytes of tables created with `opt` (for all phases) */
+    static size_t footprint(const TableOption &opt);
+
+    /* t[i][s] = coord2i( i2cc(i)^s ) */
+    template<typename Table, typename F1, typename F2>
+    std::enable_if_t<Table::shape[1] == N_SYM_D4h> 
+    buildConjTable(Table &t, F1&& coord2i, F2&& i2cc, std::string name);
+
+    /* t[i] = (c << 4) | s, where i2cc(i)^s is the representative of class c */
+    template<typename Table, typename F1, typename F2>
+    void buildClassTable(Table &t, size_t n_class, F1&& coord2i, F2&& i2cc, std::string name);
+
+    /* t[c] = the representative of class c */
+    template<typename Table, typename ClassTable>
+    void buildRepTable(Table &t, const ClassTable &cls, std::string name);
+
+    /* t[c] = bitmask of symmetries fixing the representative of class c */
+    template<typename Table, typename RepTable, typename F1, typename F2>
+    void buildSelfTable(Table &t, const RepTable &rep, F1&& coord2i, F2&& i2cc, std::string name);
+
+    NArray<T,N_TWIST,N_SYM_D4h>         *pTSTwistConj       = nullptr;
+    NArray<uint32_t,N_SLICE,N_FLIP>     *pTSFlipSlice       = nullptr;
+    NArray<uint32_t,EQ_FLIPSLICE>       *pTSFlipSliceRep    = nullptr;
+    NArray<uint16_t,EQ_FLIPSLICE>       *pTSFlipSliceSelf   = nullptr;
+
+    NArray<T,N_EDGE8,N_SYM_D4h>         *pTSEdge8Conj       = nullptr;
+    NArray<T,N_EDGE4,N_SYM_D4h>         *pTSEdge4Conj       = nullptr;
+    NArray<uint16_t,N_CORNER>           *pTSCorner          = nullptr;
+    NArray<uint16_t,EQ_CORNER>          *pTSCornerRep       = nullptr;
+    NArray<uint16_t,EQ_CORNER>          *pTSCornerSelf      = nullptr;
 };
 
 ///
@@ -95,29 +316,104 @@ struct TableMove
  * the following properties are useful (m is in ElementaryMove):
  *  1. dist(c) >= coord_i(c);
  *  2. pt_i(c*m) - pt_i(c) is in {-1,0,1};
+ * The symmetry-reduced FlipSliceTwist table (created with `sym_ph1`, 
+ * otherwise TwistSlice and FlipSlice bound phase 1) stores the exact phase 1
+ * distance, indexed by [flipslice class][twist^s] (see TableSymmetry); the 
+ * optional CornerEdge8 table (created with `sym_ph2`) bounds the phase 2 
+ * distance likewise, indexed by [corner class][edge8^s]. The optional 
+ * CornerEdge8Edge4 table (created with `exact_ph2`, ~335MB, and ~1.9GB 
+ * while it is built) stores the exact phase 2 distance, indexed by 
+ * [corner class][edge8^s][edge4^s / 2] (of edge4 ranks 2i and 2i+1, one 
+ * is even and one odd, and the parity is fixed by corner and edge8), which
+ * makes the CornerEdge8 table redundant (it is not created then). They are packed: by property 2, an
+ * entry only needs to store the distance mod 3 (2 bits), and the exact 
+ * distance is recovered from that of a neighbor (see TwoPhaseSolver::depth3).
+ * The 2-D tables are indexed [large coord][small coord]: the coords a search
+ * visits share few values of the small coord (slice, edge4), so entries of
+ * one large coord fall in one or a few cache lines (see bench/layout_bench,
+ * ~30% fewer L2 misses per phase 2 node than [small][large]).
+ * TwistSlice, FlipSlice, FlipSliceTwist are of phase 1, the others of 
+ * phase 2 but CornerTwist, the pattern database of the optimal solver (of
+ * TABLE_OPT, ~1.5MB): the distance of corners (permutation and twist) over
+ * all moves, indexed by [corner class][twist^s] and packed likewise. The 
+ * tables of phases not in `phases` are nullptr.
  */
 template<typename T=default_pt_value_t>
-struct TablePrunning
+struct TablePrunning: TableBase
 {
     using value_type = T;
-    TablePrunning(std::string dir="");
+    TablePrunning(unsigned phases=TABLE_ALL, const TableOption &opt=table_option());
     TablePrunning(const TablePrunning &) = delete;
-    ~TablePrunning();
     TablePrunning operator=(const TablePrunning &) = delete;
 
+    /* the bytes of tables created with `opt` (for all phases) */
+    static size_t footprint(const TableOption &opt);
+
     template<typename Table, typename MT1, typename MT2>
     std::enable_if_t<Table::shape[0] == MT1::shape[1] && Table::shape[1] == MT2::shape[1]> 
-    buildPrunningTable(Table &t, const MT1 &mt1, const MT2 &mt2, std::string filename);
+    buildPrunningTable(Table &t, const MT1 &mt1, const MT2 &mt2, std::string name);
 
-    /* directory to save tables */
-    const std::filesystem::path tdir;
+    /* the phase 1 table on (flipslice class, twist), packed mod 3 */
+    template<typename Table, typename TM, typename TS>
+    void buildFlipSliceTwistTable(Table &t, const TM &tm, const TS &ts, std::string name);
+
+    /* the phase 2 table on (corner class, edge8), packed mod 3 */
+    template<typename Table, typename TM, typename TS>
+    void buildCornerEdge8Table(Table &t, const TM &tm, const TS &ts, std::string name);
 
-    NArray<T,N_SLICE,N_FLIP>   *pTPSliceFlip;
-    NArray<T,N_SLICE,N_TWIST>  *pTPSliceTwist;
-    NArray<T,N_EDGE4,N_EDGE8>  *pTPEdge4Edge8;
-    NArray<T,N_EDGE4,N_CORNER> *pTPEdge4Corner;
+    /* the exact phase 2 table on (corner class, edge8, edge4), packed mod 3 */
+    template<typename Table, typename TM, typename TS>
+    void buildCornerEdge8Edge4Table(Table &t, const TM &tm, const TS &ts, std::string name);
+
+    /* the corner table on (corner class, twist) over all moves, packed mod 3;
+     * twist moves by `tm1`, corner by `tm2` */
+    template<typename Table, typename TM, typename TS>
+    void buildCornerTwistTable(Table &t, const TM &tm1, const TM &tm2, const TS &ts, std::string name);
+
+    NArray<T,N_FLIP,N_SLICE>   *pTPFlipSlice    = nullptr;
+    NArray<T,N_TWIST,N_SLICE>  *pTPTwistSlice   = nullptr;
+    NArray<T,N_EDGE8,N_EDGE4>  *pTPEdge8Edge4   = nullptr;
+    NArray<T,N_CORNER,N_EDGE4> *pTPCornerEdge4  = nullptr;
+    PackedNArray<EQ_FLIPSLICE,N_TWIST> *pTPFlipSliceTwist = nullptr;   // optional
+    PackedNArray<EQ_CORNER,N_EDGE8>    *pTPCornerEdge8 = nullptr;   // optional
+    PackedNArray<EQ_CORNER,N_EDGE8,N_EDGE4/2> *pTPCornerEdge8Edge4 = nullptr;  // optional
+    PackedNArray<EQ_CORNER,N_TWIST>    *pTPCornerTwist = nullptr;   // TABLE_OPT
 };
 
-/* symmetry table 
-d(s^-1*x*s,1) = d(x,1), s in S.
-*/
+/* the count of cubes within d moves of id, d = 0..7 */
+inline constexpr size_t N_BALL[] = { 1, 19, 262, 3502, 46741, 621649, 8240087, 109043123 };
+
+/*!
+ * @brief The table of cubes near id
+ * @details
+ * The optional endgame table (created with `TableOption::endgame` = D > 0) 
+ * holds every cube within D moves of id with its distance: the cubes are 
+ * hashed to keys whose low 3 bits are replaced by the distance, and sorted, 
+ * so that a cube is looked up by binary search (~5MB, ~66MB and ~870MB for
+ * D = 5, 6, 7; ~1.8GB while D = 7 is built). Cubes whose keys collide share 
+ * the smaller distance (the array is padded with ~0), so a distance is 
+ * only a hint: a maneuver derived from it must be checked to reach id (see
+ * TwoPhaseSolver::descend_endgame_). The table does not depend on phases.
+ */
+struct TableEndgame: TableBase
+{
+    TableEndgame(unsigned phases=TABLE_ALL, const TableOption &opt=table_option());
+    TableEndgame(const TableEndgame &) = delete;
+    TableEndgame& operator=(const TableEndgame &) = delete;
+
+    /* the bytes of tables created with `opt` */
+    static size_t footprint(const TableOption &opt);
+
+    /* the key of `cc`, whose low 3 bits are 0 */
+    static uint64_t key(const CubieCube &cc);
+
+    /* the distance of `cc` to id if it is in the table, -1 otherwise */
+    int distance(const CubieCube &cc) const;
+
+    /* t = the sorted keys of cubes within `depth` moves of id */
+    template<typename Table>
+    void buildBallTable(Table &t, unsigned depth, std::string name);
+
+    unsigned        depth = 0;
+    const uint64_t *pTEBall = nullptr;  // optional, N_BALL[depth] keys
+};
@@ -0,0 +1,60 @@
+/*!
+ * @brief Generate the table bundle at build time (see EMBED_TABLES)
+ * @details usage: cube_tablegen <dir> [--sym-ph2] [--flipslice] [--compress]
+ * writes <dir>/tables.bin holding all tables, including the optional 
+ * phase 2 symmetry tables with --sym-ph2 and the optional phase 1 flipslice
+ * move table with --flipslice. With --compress the tables are stored 
+ * compressed, to distribute the bundle (they are decoded when loaded).
+ */
+#include "table.hh"
+#include "storage.hh"
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+    if(argc < 2) {
+        std::fprintf(stderr, "usage: %s <dir> [--sym-ph2] [--flipslice] [--compress]\n", argv[0]);
+        return 2;
+    }
+    auto &opt = table_option();
+    opt.dir = argv[1];
+    opt.mmap = false;
+    opt.sym_ph2 = opt.flipslice = false;
+    bool compress = false;
+    for(int i = 2; i < argc; i++) {
+        if(std::strcmp(argv[i], "--sym-ph2") == 0) opt.sym_ph2 = true;
+        if(std::strcmp(argv[i], "--flipslice") == 0) opt.flipslice = true;
+        if(std::strcmp(argv[i], "--compress") == 0) compress = true;
+    }
+    try {
+        // start from scratch, not from a stale bundle
+        std::filesystem::remove(std::filesystem::path(opt.dir) / TableBase::bundle_file);
+        SingletonTP<>::instance();
+        SingletonTM<>::instance();
+        SingletonTS<>::instance();
+        if(compress) {
+            auto path = std::filesystem::path(opt.dir) / TableBase::bundle_file;
+            std::vector<std::vector<char>> data;
+            std::vector<TableBundle::Section> secs;
+            {
+                TableBundle bundle(path, false);
+                secs = bundle.sections();
+                for(auto &s: secs) {
+                    data.emplace_back(s.bytes);
+                    if(!bundle.read(s, data.back().data())) 
+                        throw std::runtime_error("cannot read table " + s.name);
+                    s.data = data.back().data();
+                }
+            }
+            TableBundle::publish(path, secs, true);
+        }
+    } catch(const std::exception &e) {
+        std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+        return 1;
+    }
+    return 0;
+}
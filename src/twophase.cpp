@@ -1,7 +1,64 @@
 #include "twophase.hh"
+#include "symmetry.hh"
+#include "parallel.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <stdexcept>
 
-const auto  &TM = SingletonTM<>::instance();
-const auto  &TP = SingletonTP<>::instance();
+/* the tables of a phase */
+struct PhaseTables
+{
+    const TableMove<>       *tm = nullptr;
+    const TableSymmetry<>   *ts = nullptr;
+    const TablePrunning<>   *tp = nullptr;
+};
+
+/* the tables of phase 1/2, bound by TwoPhaseSolver::init */
+static std::array<PhaseTables,2> PT;
+
+/* the endgame table, bound by TwoPhaseSolver::init */
+static const TableEndgame *TE = nullptr;
+
+template<TwoPhaseSolver::enum_phase I>
+void TwoPhaseSolver::init_phase()
+{
+    static const bool ready = [](){
+        constexpr unsigned P = I == Ph1 ? TABLE_PH1 : TABLE_PH2;
+        PT[I] = { &SingletonTM<P>::instance(), &SingletonTS<P>::instance(), &SingletonTP<P>::instance() };
+        return true;
+    }();
+    (void)ready;
+}
+
+void TwoPhaseSolver::init()
+{
+    // schedule the tables of both phases before waiting for either, so that
+    // missing tables are built in one pipeline
+    SingletonTP<TABLE_PH1>::pending();
+    SingletonTP<TABLE_PH2>::pending();
+    SingletonTE::pending();
+    init_phase<Ph1>();
+    init_phase<Ph2>();
+    static const bool ready = [](){ TE = &SingletonTE::instance(); return true; }();
+    (void)ready;
+}
+
+MemoryBacking TwoPhaseSolver::backing()
+{
+    MemoryBacking b;
+    for(const auto &pt: PT) {
+        if(!pt.tm) continue;
+        b += pt.tm->backing(), b += pt.ts->backing(), b += pt.tp->backing();
+    }
+    if(TE) b += TE->backing();
+    return b;
+}
+
+size_t TwoPhaseSolver::footprint(const TableOption &opt)
+{
+    return TableMove<>::footprint(opt) + TableSymmetry<>::footprint(opt) + TablePrunning<>::footprint(opt)
+         + TableEndgame::footprint(opt);
+}
 
 /* for optimization
  * the continuation of TurnMoves A,B,C are dull (could be reduced) in cases like:
@@ -15,37 +72,168 @@ inline bool is_dull_triple(const TurnMove A, const int B, const int C)
     ;
 } 
 
+/* whether TurnMove m is a move of phase 2 */
+inline bool is_ph2_move(const int m)
+{
+    return m/3 == Ux1/3 || m/3 == Dx1/3 || m%3 == 1;
+}
+
 template<TwoPhaseSolver::enum_phase I> 
 Coord TwoPhaseSolver::transform(const Coord &c, const TurnMove &m)
 {
+    // coord-major: the children of a node share one row per table
+    const auto &TM = *PT[I].tm;
+    if constexpr (I == Ph1) if(TM.pTMFlipSliceC) {
+        auto fs = (*TM.pTMFlipSliceC)[c.slice * N_FLIP + c.flip][m];
+        return Coord { (*TM.pTMTwistC)[c.twist][m], int(fs % N_FLIP), int(fs / N_FLIP), -1,-1,-1 };
+    }
     if constexpr (I == Ph1)
     return Coord {
-        (*TM.pTMTwist)[m][c.twist], (*TM.pTMFlip)[m][c.flip], (*TM.pTMSlice)[m][c.slice],
+        (*TM.pTMTwistC)[c.twist][m], (*TM.pTMFlipC)[c.flip][m], (*TM.pTMSliceC)[c.slice][m],
         -1,-1,-1 /* -1: not used */
     };  
     else 
     return Coord {
         0,0,0,
-        (*TM.pTMCorner)[m][c.corner], (*TM.pTMEdge4)[m][c.edge4], (*TM.pTMEdge8)[m][c.edge8]
+        (*TM.pTMCornerC)[c.corner][m], (*TM.pTMEdge4C)[c.edge4][m], (*TM.pTMEdge8C)[c.edge8][m]
     };
 }
 
 template<TwoPhaseSolver::enum_phase I>
-size_t TwoPhaseSolver::distance(const Coord &c)
+size_t TwoPhaseSolver::mod3(const Coord &c)
 {
-    if constexpr (I == Ph1)
-    return std::max((*TP.pTPSliceTwist)[c.slice][c.twist], 
-                    (*TP.pTPSliceFlip)[c.slice][c.flip]);
-    else 
-    return std::max((*TP.pTPEdge4Corner)[c.edge4][c.corner], 
-                    (*TP.pTPEdge4Edge8)[c.edge4][c.edge8]);
+    const auto &TS = *PT[I].ts;
+    const auto &TP = *PT[I].tp;
+    if constexpr (I == Ph1) {
+        // (flipslice class, twist conjugated by symmetry)
+        auto cs = (*TS.pTSFlipSlice)[c.slice][c.flip];
+        return TP.pTPFlipSliceTwist->get((cs >> 4) * N_TWIST + (*TS.pTSTwistConj)[c.twist][cs & 15]);
+    } else {
+        // (corner class, edge8 [, edge4] conjugated by symmetry)
+        auto cs = (*TS.pTSCorner)[c.corner];
+        size_t e8 = (*TS.pTSEdge8Conj)[c.edge8][cs & 15];
+        if(TP.pTPCornerEdge8Edge4)
+            return TP.pTPCornerEdge8Edge4->get(((cs >> 4) * N_EDGE8 + e8) * (N_EDGE4/2) + (*TS.pTSEdge4Conj)[c.edge4][cs & 15] / 2);
+        return TP.pTPCornerEdge8->get((cs >> 4) * N_EDGE8 + e8);
+    }
+}
+
+template<TwoPhaseSolver::enum_phase I>
+bool TwoPhaseSolver::has_mod3()
+{
+    if constexpr (I == Ph1) return PT[Ph1].tp->pTPFlipSliceTwist;
+    else return PT[Ph2].tp->pTPCornerEdge8 || PT[Ph2].tp->pTPCornerEdge8Edge4;
+}
+
+template<TwoPhaseSolver::enum_phase I>
+bool TwoPhaseSolver::is_exact()
+{
+    if constexpr (I == Ph1) return PT[Ph1].tp->pTPFlipSliceTwist;
+    else return PT[Ph2].tp->pTPCornerEdge8Edge4;
+}
+
+template<TwoPhaseSolver::enum_phase I>
+size_t TwoPhaseSolver::depth3(const Coord &c, size_t d3)
+{
+    if(!has_mod3<I>()) return 0;
+    // neighbors differ in depth by -1, 0 or 1
+    switch((mod3<I>(c) + 3 - d3 % 3) % 3) {
+        case 1:     return d3 + 1;
+        case 2:     return d3 - 1;
+        default:    return d3;
+    }
+}
+
+template<TwoPhaseSolver::enum_phase I>
+size_t TwoPhaseSolver::depth3(const Coord &c)
+{
+    if(!has_mod3<I>()) return 0;
+    auto is_origin = [](const Coord &x) {
+        if constexpr (I == Ph1) return x.twist == 0 && x.flip == 0 && x.slice == 0;
+        else return x.corner == 0 && x.edge8 == 0 && (x.edge4 == 0 || !is_exact<Ph2>());
+    };
+    // descend by the moves decreasing depth (mod 3) until reaching the origin
+    size_t d = 0;
+    Coord x = c;
+    for(size_t r = mod3<I>(x); !is_origin(x); d++, r = (r + 2) % 3) {
+        auto it = std::find_if(EM<I>.begin(), EM<I>.end(), [&x,r](auto m) {
+            return mod3<I>(transform<I>(x,m)) == (r + 2) % 3;
+        });
+        if(it == EM<I>.end()) throw std::logic_error("inconsistent prunning table");
+        x = transform<I>(x,*it);
+    }
+    return d;
+}
+
+template<TwoPhaseSolver::enum_phase I>
+size_t TwoPhaseSolver::distance(const Coord &c, size_t d3)
+{
+    if constexpr (I == Ph1) {
+        if(is_exact<Ph1>()) return d3;
+        return std::max((*PT[Ph1].tp->pTPTwistSlice)[c.twist][c.slice], 
+                        (*PT[Ph1].tp->pTPFlipSlice)[c.flip][c.slice]);
+    } else {
+        if(is_exact<Ph2>()) return d3;
+        return std::max<size_t>({ (*PT[Ph2].tp->pTPCornerEdge4)[c.corner][c.edge4], 
+                                  (*PT[Ph2].tp->pTPEdge8Edge4)[c.edge8][c.edge4], d3 });
+    }
+}
+
+// the phase 1 bound of OptimalSolver
+template Coord TwoPhaseSolver::transform<TwoPhaseSolver::Ph1>(const Coord&, const TurnMove&);
+template size_t TwoPhaseSolver::depth3<TwoPhaseSolver::Ph1>(const Coord&, size_t);
+template size_t TwoPhaseSolver::depth3<TwoPhaseSolver::Ph1>(const Coord&);
+template size_t TwoPhaseSolver::distance<TwoPhaseSolver::Ph1>(const Coord&, size_t);
+
+bool TwoPhaseSolver::descend_ph2_(const Coord &c, size_t d)
+{
+    // every node on the way has a child one move closer, any of which is
+    // on an optimal maneuver
+    Coord x = c;
+    for(size_t togo = d; togo > 0; togo--) {
+        nodes_[Ph2]++;
+        bool found = false;
+        for(auto m: EM<Ph2>) {
+            auto xm = transform<Ph2>(x,m);
+            if(depth3<Ph2>(xm,togo) != togo - 1) continue;
+            sofar_[Ph2][togo-1] = m;
+            x = xm, found = true;
+            break;
+        }
+        if(!found) throw std::logic_error("inconsistent prunning table");
+    }
+    nodes_[Ph2]++;
+    return true;
+}
+
+int TwoPhaseSolver::descend_endgame_(const CubieCube &cc)
+{
+    const int d = TE->distance(cc);
+    if(d < 0) return -1;
+    // moves are buffered backward, as by the searches
+    CubieCube x = cc;
+    for(int togo = d; togo > 0; togo--) {
+        auto it = std::find_if(EM0.begin(), EM0.end(), [&x,togo](auto m) {
+            return TE->distance(x * ElementaryMove[m]) == togo - 1;
+        });
+        if(it == EM0.end()) return -1;
+        sofar_[Ph1][togo-1] = *it;
+        x = x * ElementaryMove[*it];
+    }
+    return x == CubieCube::id ? d : -1;
 }
 
 template<TwoPhaseSolver::enum_phase PhX> 
-bool TwoPhaseSolver::search_phase(const Coord &c, size_t togo)
+bool TwoPhaseSolver::search_phase(const Coord &c, size_t d3, size_t togo)
 {
-    if(togo == 0) return distance<PhX>(c) == 0;
-    if(togo < distance<PhX>(c)) return false;
+    nodes_[PhX]++;
+    if(should_stop_()) return true;
+    if(togo == 0) {
+        if(distance<PhX>(c,d3) != 0) return false;
+        // a phase 1 solution is carried on by phase 2
+        if constexpr (PhX == Ph1) return enter_ph2_(); else return true;
+    }
+    if(togo < distance<PhX>(c,d3)) return false;
     
     for(auto m: EM<PhX>)
     {
@@ -53,27 +241,73 @@ bool TwoPhaseSolver::search_phase(const Coord &c, size_t togo)
         if(is_dull_triple(m,sofar_[PhX][togo],sofar_[PhX][togo+1])) continue;
 
         sofar_[PhX][togo-1] = m;
-        bool ret = search_phase<PhX>(transform<PhX>(c,m), togo-1);
+        auto cm = transform<PhX>(c,m);
+        bool ret = search_phase<PhX>(cm, depth3<PhX>(cm,d3), togo-1);
 
-        // ret=true means we find a PhX solution within `togo` steps;
-        // early exit is fine since there won't be a shorter PhX solution  
-        // in iterative deepening search
+        // ret=true means the search is over (see enter_ph2_)
         if(ret) return true;
     }
     return false;
 }
 
+bool TwoPhaseSolver::enter_ph2_()
+{
+    // the search is over once no solution can be shorter, or once another
+    // solver found the first one
+    const int bound = bound_();
+    if(d1_ >= bound || (!best_ && bound <= maxL_)) return true;
+    // a phase 1 solution ending by a phase 2 move extends a shorter one, 
+    // whose phase 2 search covered it
+    if(d1_ > 0 && is_ph2_move(sofar_[Ph1][0])) return false;
+    set_ph_solution_<Ph1>(d1_);
+
+    auto c2 = ph2_origin_(root_);
+    const int togo = bound - 1 - d1_;
+    // most leaves are rejected by the small tables, before the packed one
+    // is descended for the depth
+    const auto &TP = *PT[Ph2].tp;
+    if(std::max((*TP.pTPCornerEdge4)[c2.corner][c2.edge4], (*TP.pTPEdge8Edge4)[c2.edge8][c2.edge4]) > togo) 
+        return false;
+    const size_t d3_2 = depth3<Ph2>(c2);
+    for(int d2 = distance<Ph2>(c2,d3_2); d2 <= togo; d2++)
+    {
+        // phase 2 continues the last moves of phase 1 (see is_dull_triple)
+        sofar_[Ph2][d2]   = d1_ > 0 ? sofar_[Ph1][0] : -1;
+        sofar_[Ph2][d2+1] = d1_ > 1 ? sofar_[Ph1][1] : -1;
+
+        // the exact table leads straight to the solution
+        bool ret2 = is_exact<Ph2>() ? descend_ph2_(c2,d3_2) : search_phase<Ph2>(c2,d3_2,d2);
+        if(stopped_) return true;
+        if(!ret2) continue;
+
+        // a shorter solution found: save it, the budget of next leaves shrinks
+        set_ph_solution_<Ph2>(d2);
+        solution_[Ph1] = get_ph_solution_<Ph1>();
+        solution_[Ph2] = get_ph_solution_<Ph2>();
+        solL_ = d1_ + d2;
+        if(shared_) {
+            int b = shared_->load();
+            while(solL_ < b && !shared_->compare_exchange_weak(b, solL_)) {}
+        }
+        if(budget_ && budget_->improved) budget_->improved(solution_[Ph1], solution_[Ph2]);
+        // no later leaf does better than d2 = 0 at this depth
+        return !best_ || d2 == 0;
+    }
+    return false;
+}
+
 Coord TwoPhaseSolver::ph2_origin_(Coord c) const
 {
     // CubieCube transform: Coord::CubieCube2Coord(Coord::Coord2CubieCube(c) * ms);
     // Table transform optimization is working for corner only 
+    const auto &TM = *PT[Ph2].tm;
     int corner = c.corner, edge4, edge8;
     // auto cp = Coord::corner2cp(c.corner);
     auto ep = Coord::see2ep(c.slice,c.edge4,c.edge8);
     for(int i = rsolution_[Ph1].first-1; i>=0; --i) 
     { 
         auto m = static_cast<TurnMove>(rsolution_[Ph1].second[i]);
-        corner = (*TM.pTMCorner)[m][corner];
+        corner = (*TM.pTMCornerC)[corner][m];
         ep = ep * ElementaryMove[m].ep; 
     }
     edge4 = Coord::ep2edge4(ep);
@@ -84,59 +318,203 @@ Coord TwoPhaseSolver::ph2_origin_(Coord c) const
 auto TwoPhaseSolver::solve(const Coord &c, int step, bool best)
     -> std::tuple<bool,std::vector<TurnMove>,std::vector<TurnMove>>
 {
+    budget_ = nullptr, pool_ = nullptr;
+    return solve_(c, step, best);
+}
+
+auto TwoPhaseSolver::solve(const Coord &c, int step, const SolveBudget &budget)
+    -> std::tuple<bool,std::vector<TurnMove>,std::vector<TurnMove>>
+{
+    budget_ = &budget, pool_ = nullptr;
+    auto r = solve_(c, step, true);
+    budget_ = nullptr;
+    return r;
+}
+
+/* the pool of a parallel solve on `threads` threads (0 => the pool of the 
+ * process, shared by all solves so that none spawns threads; otherwise 
+ * `own`, made for the call) */
+static TaskPool& solve_pool(unsigned threads, std::unique_ptr<TaskPool> &own)
+{
+    static TaskPool shared(thread_count());
+    if(threads == 0) return shared;
+    own = std::make_unique<TaskPool>(thread_count(threads));
+    return *own;
+}
+
+auto TwoPhaseSolver::solve_split(const Coord &c, int step, bool best, unsigned threads)
+    -> std::tuple<bool,std::vector<TurnMove>,std::vector<TurnMove>>
+{
+    std::unique_ptr<TaskPool> own;
+    budget_ = nullptr, pool_ = &solve_pool(threads, own);
+    // pool_ must not outlive `own`, also when the search throws
+    struct Reset { TaskPool *&pool; ~Reset() { pool = nullptr; } } reset { pool_ };
+    return solve_(c, step, best);
+}
+
+bool TwoPhaseSolver::split_ph1_(const Coord &c, size_t d3)
+{
+    // the subtrees: the nodes after the first two moves, pruned as by search_phase
+    struct Subtree { Coord c; size_t d3; int m1, m2; };
+    std::vector<Subtree> subs;
+    nodes_[Ph1]++;
+    for(auto m1: EM0) {
+        auto c1 = transform<Ph1>(c,m1);
+        auto d3_1 = depth3<Ph1>(c1,d3);
+        nodes_[Ph1]++;
+        if(size_t(d1_) - 1 < distance<Ph1>(c1,d3_1)) continue;
+        for(auto m2: EM0) {
+            if(is_dull_triple(m2,m1,-1)) continue;
+            auto c2 = transform<Ph1>(c1,m2);
+            auto d3_2 = depth3<Ph1>(c2,d3_1);
+            if(size_t(d1_) - 2 < distance<Ph1>(c2,d3_2)) { nodes_[Ph1]++; continue; }
+            subs.push_back({ c2, d3_2, m1, m2 });
+        }
+    }
+
+    // the tasks share the bound, as the views of solve_parallel
+    std::atomic<int> shared { bound_() };
+    std::atomic<bool> cancel { false };
+    std::vector<TwoPhaseSolver> tasks(subs.size());
+    std::vector<TaskPool::Handle> handles;
+    for(size_t i = 0; i < subs.size(); i++) handles.push_back(pool_->submit([&,i]() {
+        auto &t = tasks[i];
+        t.root_ = root_, t.d1_ = d1_, t.solL_ = solL_, t.maxL_ = maxL_, t.best_ = best_;
+        t.shared_ = &shared, t.cancel_ = &cancel;
+        t.sofar_ = sofar_;
+        t.sofar_[Ph1][d1_-1] = subs[i].m1, t.sofar_[Ph1][d1_-2] = subs[i].m2;
+        if(t.search_phase<Ph1>(subs[i].c, subs[i].d3, d1_-2) && !t.stopped_) cancel = true;
+    }));
+    // the tasks refer to this frame: let all of them finish before a failure
+    // is rethrown
+    std::exception_ptr error;
+    for(auto &h: handles) {
+        try { pool_->wait(h); } 
+        catch(...) { if(!error) error = std::current_exception(); cancel = true; }
+    }
+    if(error) std::rethrow_exception(error);
+
+    for(auto &t: tasks) {
+        nodes_[Ph1] += t.nodes_[Ph1], nodes_[Ph2] += t.nodes_[Ph2];
+        if(t.solL_ < solL_) solL_ = t.solL_, solution_ = t.solution_;
+    }
+    if(shared_) {
+        int b = shared_->load();
+        while(solL_ < b && !shared_->compare_exchange_weak(b, solL_)) {}
+    }
+    return cancel;
+}
+
+auto TwoPhaseSolver::solve_(const Coord &c, int step, bool best)
+    -> std::tuple<bool,std::vector<TurnMove>,std::vector<TurnMove>>
+{
+    init();
+
     const int maxL = std::min(std::max(0,step),DS);     // largest length allowed
-    int solL = maxL + 1;                                // smallest length found 
-    std::array<std::vector<TurnMove>,2> solution;       // solution
+    maxL_ = maxL;
+    root_ = c;
+    solL_ = maxL + 1;                                   // smallest length found
+    best_ = best;
+    stopped_ = false;
+    solution_ = {};
 
     // reset sofar buffer: 
     // only once is enough since `set_ph_rsolution(d)` knows exact solution length d
     reset_ph_sofar_<Ph1>(); 
     reset_ph_sofar_<Ph2>();
+    nodes_.fill(0);
+
+    // cubes near id are solved optimally, thus not within `maxL` if longer
+    if(TE->depth > 0) {
+        if(int d = descend_endgame_(Coord::Coord2CubieCube(c)); d >= 0) {
+            if(d > maxL) return std::make_tuple(false, std::vector<TurnMove>{}, std::vector<TurnMove>{});
+            set_ph_solution_<Ph1>(d);
+            auto s1 = get_ph_solution_<Ph1>();
+            if(budget_ && budget_->improved) budget_->improved(s1, {});
+            return std::make_tuple(true, s1, std::vector<TurnMove>{});
+        }
+        reset_ph_sofar_<Ph1>();
+    }
 
     ///
-    /// iterative deepening search 
+    /// iterative deepening search of phase 1, nesting that of phase 2
 
-    for(int d1 = distance<Ph1>(c); d1 <= maxL; d1++) 
+    // phase 1 solutions as long as the best solution cannot improve it; once
+    // a solution is found, phase 1 stops at D0 (the rest of the optimal search
+    // grows ~15x per move for ~0.3 move shorter solutions), unless the budget
+    // bounds it
+    const size_t d3_1 = depth3<Ph1>(c);
+    for(d1_ = distance<Ph1>(c,d3_1); d1_ < bound_() && (d1_ <= D0 || bound_() > maxL || budget_); d1_++) {
+        if(pool_ && d1_ >= 2 ? split_ph1_(c,d3_1) : search_phase<Ph1>(c,d3_1,d1_)) break;
+    }
+
+    if(solL_ > maxL) 
+        return std::make_tuple(false, std::vector<TurnMove>{}, std::vector<TurnMove>{});
+
+    VPRINT("nodes: %zu (phase 1), %zu (phase 2)\n", nodes_[Ph1], nodes_[Ph2]);
+    return std::make_tuple(true, solution_[Ph1], solution_[Ph2]);
+}
+
+auto TwoPhaseSolver::solve_parallel(const Coord &c, int step, bool best, unsigned threads)
+    -> std::tuple<bool,std::vector<TurnMove>,std::vector<TurnMove>>
+{
+    init();
+
+    // view k: the cube (k even) or its inverse (k odd), conjugated by S_URF3^(k/2)
+    constexpr int N_VIEW = 6;
+    const auto cc = Coord::Coord2CubieCube(c);
+    std::atomic<int> shared { DS + 1 };
+    std::atomic<bool> cancel { false };
+    std::array<TwoPhaseSolver,N_VIEW> solvers;
+    std::array<std::tuple<bool,std::vector<TurnMove>,std::vector<TurnMove>>,N_VIEW> results;
     {
-        // start Ph1 search
-        bool ret1 = search_phase<Ph1>(c,d1);
-        if(!ret1) continue;
-
-        // Ph1 solution found
-        set_ph_solution_<Ph1>(d1);
-
-        // start Ph2 search
-        auto c2 = ph2_origin_(c);
-        int togo = solL - 1 - rsolution_[Ph1].first;
-        for(int d2 = distance<Ph2>(c2); d2 <= togo; d2++)
-        {
-            bool ret2 = search_phase<Ph2>(c2,d2);
-            if(!ret2) continue;
-
-            // Ph2 solution found
-            set_ph_solution_<Ph2>(d2);
-
-            // save solution
-            solution[Ph1] = get_ph_solution_<Ph1>();
-            solution[Ph2] = get_ph_solution_<Ph2>();
-            solL = solution[1].size() + solution[0].size();
-            
-            if(!best) goto found; 
-            if(d2==0) goto found; else break;
-
-            /* When a solution is found, logically we should continue from next layer-peer
-               of Ph2 root, instead of the first node of layer under Ph1 root.
-               That's why the solution is not optimal.
-               We do not implement this since we tink it'll make the code 
-               complicated and may involve ineffective searches. 
-            */
+        std::unique_ptr<TaskPool> own;
+        auto &pool = solve_pool(threads ? std::min<unsigned>(N_VIEW, threads) : 0, own);
+        std::vector<TaskPool::Handle> tasks;
+        for(int k = 0; k < N_VIEW; k++) tasks.push_back(pool.submit([&,k]() {
+            auto x = Sym::conj(16 * (k / 2), k % 2 ? ~cc : cc);
+            solvers[k].shared_ = &shared, solvers[k].cancel_ = &cancel;
+            results[k] = solvers[k].solve(Coord::CubieCube2Coord(x), step, best);
+        }));
+        // as in split_ph1_: a failure cancels the other views, rethrown once
+        // they are all done
+        std::exception_ptr error;
+        for(auto &t: tasks) {
+            try { pool.wait(t); }
+            catch(...) { if(!error) error = std::current_exception(); cancel = true; }
         }
+        if(error) std::rethrow_exception(error);
     }
 
-    if(solL > maxL) 
-        return std::make_tuple(false, std::vector<TurnMove>{}, std::vector<TurnMove>{});
+    // the shortest solution, of the first view on ties
+    int k = -1;
+    size_t len = 0;
+    for(int i = 0; i < N_VIEW; i++) {
+        const auto &[found, s1, s2] = results[i];
+        if(found && (k < 0 || s1.size() + s2.size() < len)) k = i, len = s1.size() + s2.size();
+    }
+    if(k < 0) return std::make_tuple(false, std::vector<TurnMove>{}, std::vector<TurnMove>{});
 
-    // solution found 
-    found: 
-    return std::make_tuple(true, solution[0], solution[1]);
+    // if s*x*s^-1 is solved by moves m, x is solved by s^-1*m*s
+    static const auto conj_move = [](){
+        std::array<std::array<TurnMove,N_MOVE>,3> t;
+        for(int u = 0; u < 3; u++) for(int m = 0; m < N_MOVE; m++) {
+            auto x = Sym::conj(Sym::inv(16 * u), ElementaryMove[m]);
+            t[u][m] = static_cast<TurnMove>(std::find(ElementaryMove.begin(), ElementaryMove.end(), x) - ElementaryMove.begin());
+        }
+        return t;
+    }();
+    auto back = [k](std::vector<TurnMove> ms) {
+        for(auto &m: ms) m = conj_move[k / 2][m];
+        return ms;
+    };
+    // if x^-1 is solved by moves m1..mn, x is solved by mn^-1..m1^-1
+    auto inverse = [](std::vector<TurnMove> ms) {
+        std::reverse(ms.begin(), ms.end());
+        for(auto &m: ms) m = static_cast<TurnMove>(m / 3 * 3 + 2 - m % 3);
+        return ms;
+    };
+    auto s1 = back(std::get<1>(results[k])), s2 = back(std::get<2>(results[k]));
+    if(k % 2) return std::make_tuple(true, inverse(s2), inverse(s1));
+    return std::make_tuple(true, s1, s2);
 }
\ No newline at end of file
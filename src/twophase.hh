@@ -5,9 +5,24 @@
 #include "table.hh"
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <vector>
 #include <tuple>
 
+class TaskPool;
+
+/* the budget of an anytime solve (see TwoPhaseSolver::solve) */
+struct SolveBudget
+{
+    using clock = std::chrono::steady_clock;
+    clock::time_point   deadline  = clock::time_point::max();
+    size_t              max_nodes = 0;      // 0 => no limit
+    /* (may be empty) called with each shorter solution (sol1,sol2) found */
+    std::function<void(const std::vector<TurnMove>&,const std::vector<TurnMove>&)> improved;
+};
+
 /*! 
  * @brief Kociemba's twophase algorithm
  */
@@ -22,19 +37,79 @@ public:
      * @param best try its best to find the short (but slower) solution 
      * @return (is_solved,sol1,sol2) 
      * @implements 
-     * We adopt two iterative deepening searches in series rather than nesting 
-     * them, as in original Kociemba's algorithm. This simplifies the 
-     * implementation, but sacrifies the ease of extending the algorithm to 
-     * find optimal solution. 
+     * Kociemba's nested search: phase 1 is searched by iterative deepening,
+     * and each of its solutions (of every length) is carried on by a phase 2
+     * search within the length left by the shortest solution found so far
+     * (see enter_ph2_).
      * 
      * If `best` is false, the search will stop as soon as a solution is found;
-     * otherwise, the search will continue to shorter solution is impossible.
-     * Note the eventual solution is not guaranteed to be optimal.
+     * otherwise, phase 1 goes on until its length reaches that of the
+     * shortest solution (which is then optimal) or D0, whichever is first.
+     * The cubes of the endgame table
+     * (see TableEndgame) are solved optimally by descending it, in sol1 
+     * (sol2 is empty).
      */
     auto solve(const Coord &c, int step, bool best) -> std::tuple<bool,std::vector<TurnMove>,std::vector<TurnMove>>;
 
+    /*!
+     * @brief Anytime `solve`: improve the solution until none is shorter or
+     * `budget` runs out, then return the shortest found
+     * @details As `solve` with `best`, but phase 1 goes on past D0. The budget
+     * is checked every 256 nodes (some µs); the search then unwinds at once. 
+     * Without a solution found by then, is_solved is false.
+     */
+    auto solve(const Coord &c, int step, const SolveBudget &budget) -> std::tuple<bool,std::vector<TurnMove>,std::vector<TurnMove>>;
+
+    /*!
+     * @brief `solve` on six views of `c` in parallel
+     * @details The views are `c` and its inverse, each conjugated by S_URF3^k
+     * (k = 0,1,2) so that each of the three axes is searched as the UD axis.
+     * The searches run as tasks of a pool of `threads` threads (at most 6;
+     * 0 => the pool of the process, see solve_split) and share the length of
+     * the shortest solution, which bounds them all; if `best` is false, they
+     * all stop at the first solution. The solution of a view is translated back to `c`.
+     */
+    static auto solve_parallel(const Coord &c, int step, bool best, unsigned threads = 0) 
+        -> std::tuple<bool,std::vector<TurnMove>,std::vector<TurnMove>>;
+
+    /*!
+     * @brief `solve` with one search split among `threads` threads (0 => 
+     * the pool of the process, of hardware concurrency, which all parallel
+     * solves share so that none spawns threads)
+     * @details Each depth of phase 1 (from 2) is split by its first two moves
+     * into subtrees, searched as tasks of a pool whose threads take the next
+     * queued subtree once idle. The tasks share the length of the shortest
+     * solution, which bounds them all; the first task that ends the search 
+     * (see enter_ph2_) cancels the others. Unlike `solve_parallel`, all 
+     * threads work on one view, so it lowers the latency of the same search.
+     * The pool queue is central rather than work-stealing: a depth has at 
+     * most a few hundred subtrees (of ~100-5000 nodes each with the large 
+     * tier), so its lock is taken rarely next to the search.
+     */
+    auto solve_split(const Coord &c, int step, bool best, unsigned threads = 0)
+        -> std::tuple<bool,std::vector<TurnMove>,std::vector<TurnMove>>;
+
+    /* load (or build) the tables of both phases, if not yet; `solve` calls
+     * it on first use. (throw) on failures to create tables */
+    static void init();
+
+    /* the memory backing of tables bound by `init` (zero before) */
+    static MemoryBacking backing();
+
+    /* the bytes of tables that `init` creates with `opt` */
+    static size_t footprint(const TableOption &opt);
+
+    /* the count of nodes visited in phase 1/2 by the last solve (for benchmark) */
+    auto nodes() const -> std::array<size_t,2> { return nodes_; }
+
 protected:
+    // bounds its search by the distance of phase 1
+    friend class OptimalSolver;
+
     enum enum_phase { Ph1=0, Ph2=1 };
+
+    /* load (or build) the tables of phase 1/2 independently, once */
+    template<enum_phase PhX> static void init_phase();
     
     /*! 
      * @brief The search algorithm in PhX 
@@ -44,16 +119,39 @@ protected:
      * a node is considered a solution if its coord satisfies `distance<PHX>(c) == 0`. 
      *
      * During DFS traversal, the current move is always cached in the buffer at index `togo-1`; 
-     * if a solution node is found, the buffer is flushed to the solution and return true;
-     * otherwise, all nodes within depth `togo` are explored and return false. 
+     * a solution node of phase 1 is carried on by phase 2 (see enter_ph2_), 
+     * and true is returned once the whole search is over; a solution node of
+     * phase 2 returns true at once. Otherwise, all nodes within depth `togo` 
+     * are explored and return false. 
+     *
+     * `d3` is the depth of `c` in the packed table of PhX (see depth3), which
+     * is passed down the tree since the table only stores it mod 3.
      */
-    template<enum_phase PhX> bool search_phase(const Coord &c, size_t togo);
+    template<enum_phase PhX> bool search_phase(const Coord &c, size_t d3, size_t togo);
 
     /* move-table based coord transform */
     template<enum_phase PhX> static Coord transform(const Coord &c, const TurnMove &m);
 
-    /* prunning-talbe based lower bound distance in phase 1/2 */
-    template<enum_phase PhX> static size_t distance(const Coord &c);
+    /* whether the packed prunning table of phase 1/2 was created (see TableOption) */
+    template<enum_phase PhX> static bool has_mod3();
+
+    /* whether the packed prunning table of phase 1/2 holds the exact distance */
+    template<enum_phase PhX> static bool is_exact();
+
+    /* the entry of `c` in the packed prunning table of phase 1/2 (depth mod 3) */
+    template<enum_phase PhX> static size_t mod3(const Coord &c);
+
+    /* the depth of `c` in the packed (mod 3) prunning table of phase 1/2 
+     * (0 if absent), recovered from `d3` of its neighbor in the search tree */
+    template<enum_phase PhX> static size_t depth3(const Coord &c, size_t d3);
+
+    /* the depth of `c` in the packed prunning table, recovered by descending
+     * to the origin; for search roots */
+    template<enum_phase PhX> static size_t depth3(const Coord &c);
+
+    /* prunning-talbe based lower bound distance in phase 1/2, given depth3 */
+    template<enum_phase PhX> static size_t distance(const Coord &c, size_t d3);
+    template<enum_phase PhX> static size_t distance(const Coord &c) { return distance<PhX>(c, depth3<PhX>(c)); }
 
     /* max search depth for phase 1/2 (conclusion from literatures) */
     static constexpr int D0 = 12, D1 = 18, DS = D0+D1;
@@ -91,9 +189,59 @@ private:
         return sol;
     }
 
+    /* search phase 2 from the phase 1 solution of length d1_ in sofar_, 
+     * for a solution shorter than bound_() (which is saved to solution_); 
+     * return whether the whole search is over */
+    bool enter_ph2_();
+
+    /* the search of both `solve`s, within budget_ if not null */
+    auto solve_(const Coord &c, int step, bool best) -> std::tuple<bool,std::vector<TurnMove>,std::vector<TurnMove>>;
+
+    /* whether the search must stop: budget_ ran out (see SolveBudget), or 
+     * cancel_ was set by another task (see solve_split) */
+    bool should_stop_()
+    {
+        if(stopped_) return true;
+        if(cancel_ && cancel_->load(std::memory_order_relaxed)) return stopped_ = true;
+        if(!budget_) return false;
+        const size_t n = nodes_[Ph1] + nodes_[Ph2];
+        if(budget_->max_nodes && n >= budget_->max_nodes) return stopped_ = true;
+        if(n % 256 == 0 && SolveBudget::clock::now() >= budget_->deadline) return stopped_ = true;
+        return false;
+    }
+
+    /* search_phase<Ph1> at depth d1_ (>= 2) from `c`, split into tasks on 
+     * pool_ (see solve_split); return whether the search is over */
+    bool split_ph1_(const Coord &c, size_t d3);
+
+    /* the length that solutions must be shorter than: solL_, and the shortest
+     * one of the solvers sharing `shared_` */
+    int bound_() const { return shared_ ? std::min(solL_, shared_->load(std::memory_order_relaxed)) : solL_; }
+
     /* the origin of phase 2, evaluated from phase 1 solution */
     Coord ph2_origin_(Coord c) const;
 
+    /* solve phase 2 from `c` at exact depth `d` by descending the exact 
+     * table (greedy, without backtracking) */
+    bool descend_ph2_(const Coord &c, size_t d);
+
+    /* solve `cc` optimally by descending the endgame table into sofar_[Ph1]
+     * (as the phase 1 solution), return its length, or -1 if `cc` is not in
+     * the table or the descent is misled by colliding keys */
+    int descend_endgame_(const CubieCube &cc);
+
     std::array<std::array<int,DS+2>,2>                  sofar_;      // solution buffer
     std::array<std::pair<size_t,std::array<int,DS>>,2>  rsolution_;  // reverse of temp solution
+    std::array<size_t,2>                                nodes_ {};   // visited nodes per phase
+    Coord                                               root_;       // the cube to solve
+    int                                                 d1_ = 0;     // the depth of phase 1 search
+    int                                                 solL_ = 0;   // the length of solution_ (or max+1)
+    int                                                 maxL_ = 0;   // the max length allowed
+    std::atomic<int>                                   *shared_ = nullptr; // see solve_parallel
+    bool                                                best_ = false;
+    const SolveBudget                                  *budget_ = nullptr;
+    bool                                                stopped_ = false; // by budget_ or cancel_
+    TaskPool                                           *pool_ = nullptr;   // see solve_split
+    std::atomic<bool>                                  *cancel_ = nullptr; // see solve_split
+    std::array<std::vector<TurnMove>,2>                 solution_;   // the shortest solution found
 };
\ No newline at end of file
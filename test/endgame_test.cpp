@@ -0,0 +1,36 @@
+#include "cube/libcube.h"
+#include "twophase.hh"
+#include "utils.hpp"
+#include <gtest/gtest.h>
+
+// the endgame depth is fixed once the tables are loaded, which is once per
+// process: this test runs in an executable of its own, before any solve
+
+static auto solve(TwoPhaseSolver &s, const char *maneuver, int step)
+{
+    auto cc = CubieCube::id * string_to_moves<TurnMove>(maneuver);
+    auto [found, s1, s2] = s.solve(Coord::CubieCube2Coord(cc), step, false);
+    EXPECT_TRUE(!found || cc * s1 * s2 == CubieCube::id);
+    return std::make_tuple(found, s1.size() + s2.size());
+}
+
+TEST(EndgameTest,BasicAssertions)
+{
+    EXPECT_EQ(set_solver_endgame(8), CODE_UNKNOWN_ERROR);
+    EXPECT_EQ(set_solver_endgame(5), CODE_OK);
+    EXPECT_EQ(init_solver(), CODE_OK);
+    TwoPhaseSolver s;
+    // within the table: walked down optimally, without any search
+    EXPECT_EQ(solve(s, "URF", 30), std::make_tuple(true, size_t(3)));
+    EXPECT_EQ(s.nodes(), (std::array<size_t,2>{ 0, 0 }));
+    EXPECT_EQ(solve(s, "RUR'U'F2", 30), std::make_tuple(true, size_t(5)));
+    EXPECT_EQ(s.nodes(), (std::array<size_t,2>{ 0, 0 }));
+    EXPECT_EQ(solve(s, "RUR'U'F2", 4), std::make_tuple(false, size_t(0)));
+    EXPECT_EQ(s.nodes(), (std::array<size_t,2>{ 0, 0 }));
+    // beyond the table: searched
+    EXPECT_TRUE(std::get<0>(solve(s, "RUR'U'F2D", 30)));
+    EXPECT_GT(s.nodes()[0], 0u);
+    // the tables are loaded: the depth is fixed
+    EXPECT_EQ(set_solver_endgame(6), CODE_UNKNOWN_ERROR);
+    EXPECT_EQ(set_solver_endgame(5), CODE_OK);
+}
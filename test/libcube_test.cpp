@@ -3,6 +3,8 @@
 #include <gtest/gtest.h>
 #include <string>
 #include <cstring>
+#include <thread>
+#include <vector>
 
 const std::string Move2Str[18] = { "U","U2","U'","R","R2","R'","F","F2","F'","D","D2","D'","L","L2","L'","B","B2","B'" };
 
@@ -35,6 +37,11 @@ TEST(SolveTest, BasicAssertions)
     int rc = solve_ultimate(cube, CUBE_ID, buffer, 30, 0, 0);
     EXPECT_EQ(rc,0);
     EXPECT_TRUE(check_solution(cube, buffer));
+    // the nested search finds the shortest solution
+    rc = solve_ultimate(cube, CUBE_ID, buffer, 30, 1, 0);
+    EXPECT_EQ(rc,0);
+    EXPECT_TRUE(check_solution(cube, buffer));
+    EXPECT_EQ(strlen(buffer), 3u);
 }
 
 TEST(PermutationTest,BasicAssertions)
@@ -70,3 +77,113 @@ TEST(ColorTest,BasicAssertions)
     facecube(buf,"F",buf2);
     EXPECT_STREQ(buf2,"UUFUUFLLLURRURRFRRFFFFFFDDDRRRDDBDDBLLDLLDLLBUBBUBBUBB");
 }
+
+TEST(WarmupTest,BasicAssertions)
+{
+    char cube[CUBE_BS], buffer[CUBE_BS];
+    EXPECT_EQ(solver_state(), TABLES_NONE);
+    EXPECT_EQ(wait_solver(0), CODE_NOT_READY);
+    EXPECT_EQ(init_solver_async(), CODE_OK);
+    EXPECT_NE(solver_state(), TABLES_NONE);
+    EXPECT_EQ(wait_solver(-1), CODE_OK);
+    EXPECT_EQ(solver_state(), TABLES_READY);
+    facecube(NULL, "URF", cube);
+    EXPECT_EQ(solve_ultimate(cube, CUBE_ID, buffer, 30, 0, 0), CODE_OK);
+    EXPECT_TRUE(check_solution(cube, buffer));
+}
+
+TEST(ParallelTest,BasicAssertions)
+{
+    char cube[CUBE_BS], buffer[CUBE_BS];
+    facecube(NULL, "URFDLB", cube);
+    EXPECT_EQ(solve_ultimate(cube, CUBE_ID, buffer, 30, SOLVE_PARALLEL, 0), CODE_OK);
+    EXPECT_TRUE(check_solution(cube, buffer));
+    EXPECT_EQ(solve_ultimate(cube, CUBE_ID, buffer, 30, SOLVE_BEST | SOLVE_PARALLEL, 0), CODE_OK);
+    EXPECT_TRUE(check_solution(cube, buffer));
+    EXPECT_EQ(strlen(buffer), 6u);
+    EXPECT_EQ(solve_ultimate(cube, CUBE_ID, buffer, 5, SOLVE_BEST | SOLVE_PARALLEL, 0), CODE_NOT_FOUND);
+}
+
+TEST(SplitTest,BasicAssertions)
+{
+    char cube[CUBE_BS], buffer[CUBE_BS];
+    facecube(NULL, "URFDLB", cube);
+    EXPECT_EQ(solve_ultimate(cube, CUBE_ID, buffer, 30, SOLVE_SPLIT, 0), CODE_OK);
+    EXPECT_TRUE(check_solution(cube, buffer));
+    EXPECT_EQ(solve_ultimate(cube, CUBE_ID, buffer, 30, SOLVE_BEST | SOLVE_SPLIT, 0), CODE_OK);
+    EXPECT_TRUE(check_solution(cube, buffer));
+    EXPECT_EQ(strlen(buffer), 6u);
+    EXPECT_EQ(solve_ultimate(cube, CUBE_ID, buffer, 5, SOLVE_BEST | SOLVE_SPLIT, 0), CODE_NOT_FOUND);
+}
+
+TEST(OptimalTest,BasicAssertions)
+{
+    char cube[CUBE_BS], buffer[CUBE_BS];
+    int bound = -1;
+    EXPECT_EQ(solve_optimal(CUBE_ID, CUBE_ID, buffer, 30, 0, &bound), CODE_OK);
+    EXPECT_EQ(bound, 0);
+    // cancelling moves: 8 turns of 5 moves
+    facecube(NULL, "D2 B' F' B F' L2 U2 R'", cube);
+    EXPECT_EQ(solve_optimal(cube, CUBE_ID, buffer, 30, 0, &bound), CODE_OK);
+    EXPECT_TRUE(check_solution(cube, buffer));
+    EXPECT_EQ(strlen(buffer), 5u);
+    EXPECT_EQ(bound, 5);
+    facecube(NULL, "U L R' U2 B2 L2 B2 D L' U' D' L", cube);
+    EXPECT_EQ(solve_ultimate(cube, CUBE_ID, buffer, 30, SOLVE_OPTIMAL, 0), CODE_OK);
+    EXPECT_TRUE(check_solution(cube, buffer));
+    EXPECT_EQ(strlen(buffer), 12u);
+    // no solution of at most 10 moves
+    EXPECT_EQ(solve_optimal(cube, CUBE_ID, buffer, 10, 0, &bound), CODE_NOT_FOUND);
+    EXPECT_EQ(bound, 11);
+}
+
+static void count_improved(const char *, void *user) { ++*static_cast<int*>(user); }
+
+TEST(AnytimeTest,BasicAssertions)
+{
+    char cube[CUBE_BS], buffer[CUBE_BS];
+    facecube(NULL, "URFDLB", cube);
+    // without limits, the search goes on until the solution is optimal
+    int improved = 0;
+    EXPECT_EQ(solve_anytime(cube, CUBE_ID, buffer, 30, 0, 0, 0, count_improved, &improved), CODE_OK);
+    EXPECT_TRUE(check_solution(cube, buffer));
+    EXPECT_EQ(strlen(buffer), 6u);
+    EXPECT_GE(improved, 1);
+    EXPECT_EQ(solve_anytime(cube, CUBE_ID, buffer, 30, 1000000, 0, 0, nullptr, nullptr), CODE_OK);
+    EXPECT_TRUE(check_solution(cube, buffer));
+    // no solution within one node
+    EXPECT_EQ(solve_anytime(cube, CUBE_ID, buffer, 30, 0, 1, 0, nullptr, nullptr), CODE_NOT_FOUND);
+    // the cube is checked as by solve_ultimate, before the tables are touched
+    std::string flipped = CUBE_ID;
+    std::swap(flipped[1], flipped[46]);
+    EXPECT_EQ(solve_anytime(flipped.c_str(), CUBE_ID, buffer, 30, 0, 0, 0, nullptr, nullptr), CODE_UNSOLVABLE);
+    EXPECT_EQ(solve_anytime("UUU", CUBE_ID, buffer, 30, 0, 0, 0, nullptr, nullptr), CODE_INVALID_SRC);
+}
+
+TEST(ConcurrentTest,BasicAssertions)
+{
+    // scrambles of 10 moves, solved serially for reference
+    const int n_cube = 16, n_thread = 8;
+    std::vector<std::string> cubes, expected;
+    unsigned x = 1;
+    for(int i = 0; i < n_cube; i++) {
+        std::string m;
+        for(int k = 0; k < 10; k++) x = x * 1103515245 + 12345, m += Move2Str[(x >> 16) % 18] + " ";
+        char cube[CUBE_BS], buffer[CUBE_BS];
+        facecube(NULL, m.c_str(), cube);
+        ASSERT_EQ(solve_ultimate(cube, CUBE_ID, buffer, 30, SOLVE_FIRST, 1), CODE_OK);
+        cubes.push_back(cube), expected.push_back(buffer);
+    }
+    // every thread solves all of them, from a different one, without a lock
+    std::vector<std::vector<std::string>> results(n_thread, std::vector<std::string>(n_cube));
+    std::vector<std::thread> threads;
+    for(int t = 0; t < n_thread; t++) threads.emplace_back([&,t]() {
+        for(int j = 0; j < n_cube; j++) {
+            int i = (t + j) % n_cube;
+            char buffer[CUBE_BS];
+            if(solve_ultimate(cubes[i].c_str(), CUBE_ID, buffer, 30, SOLVE_FIRST, 1) == CODE_OK) results[t][i] = buffer;
+        }
+    });
+    for(auto &t: threads) t.join();
+    for(int t = 0; t < n_thread; t++) for(int i = 0; i < n_cube; i++) EXPECT_EQ(results[t][i], expected[i]);
+}
@@ -0,0 +1,41 @@
+#include "symmetry.hh"
+#include "cube.hh"
+#include <gtest/gtest.h>
+#include <algorithm>
+
+static bool equal(const SymCube &a, const SymCube &b)
+{
+    return a.cp == b.cp && a.co == b.co && a.ep == b.ep && a.eo == b.eo;
+}
+
+TEST(SymmetryTest, Group)
+{
+    const auto &S = Sym::cube();
+    const auto id = SymCube::fromCubieCube(CubieCube::id);
+    EXPECT_TRUE(equal(S[0], id));
+    for(int s = 0; s < N_SYM; s++) {
+        EXPECT_TRUE(equal(S[s] * S[Sym::inv(s)], id));
+    }
+    // D4h is closed under multiplication
+    for(int s = 0; s < N_SYM_D4h; s++) for(int t = 0; t < N_SYM_D4h; t++) {
+        auto st = S[s] * S[t];
+        EXPECT_TRUE(std::any_of(S.begin(), S.begin()+N_SYM_D4h, 
+            [&st](const SymCube &x) { return equal(x, st); }));
+    }
+}
+
+TEST(SymmetryTest, Conjugation)
+{
+    // a conjugated elementary move is an elementary move
+    for(int s = 0; s < N_SYM; s++) for(auto &m: ElementaryMove) {
+        auto mc = Sym::conj(s, m);
+        EXPECT_TRUE(std::find(ElementaryMove.begin(), ElementaryMove.end(), mc) != ElementaryMove.end());
+    }
+    // conjugation is a homomorphism 
+    auto x = CubieCube::id * std::vector<TurnAxis>{U,R,D,B,L,F,D,R};
+    auto y = CubieCube::id * std::vector<TurnAxis>{F,F,L,B,U};
+    for(int s = 0; s < N_SYM; s++) {
+        EXPECT_EQ(Sym::conj(s, x*y), Sym::conj(s, x) * Sym::conj(s, y));
+        EXPECT_TRUE(Sym::conj(s, x).isSolvable());
+    }
+}
@@ -0,0 +1,23 @@
+#include "cube/libcube.h"
+#include <gtest/gtest.h>
+
+// the tier is fixed once the tables are loaded, which is once per process:
+// this test runs in an executable of its own, before any solve
+
+TEST(TierTest,BasicAssertions)
+{
+    char cube[CUBE_BS], buffer[CUBE_BS];
+    EXPECT_EQ(solver_tier_info(-1, buffer), -1);
+    EXPECT_LT(solver_tier_info(TIER_MINIMAL, buffer), solver_tier_info(TIER_STANDARD, buffer));
+    EXPECT_LT(solver_tier_info(TIER_STANDARD, buffer), solver_tier_info(TIER_LARGE, buffer));
+    EXPECT_LT(solver_tier_info(TIER_LARGE, buffer), solver_tier_info(TIER_EXACT, buffer));
+    EXPECT_EQ(set_solver_tier(4), CODE_UNKNOWN_ERROR);
+    EXPECT_EQ(set_solver_tier(TIER_MINIMAL), CODE_OK);
+    EXPECT_EQ(get_solver_tier(), TIER_MINIMAL);
+    facecube(NULL, "URF", cube);
+    EXPECT_EQ(solve_ultimate(cube, CUBE_ID, buffer, 30, 0, 0), CODE_OK);
+    // the tables are loaded: the tier is fixed
+    EXPECT_EQ(set_solver_tier(TIER_LARGE), CODE_UNKNOWN_ERROR);
+    EXPECT_EQ(set_solver_tier(TIER_MINIMAL), CODE_OK);
+    EXPECT_EQ(get_solver_tier(), TIER_MINIMAL);
+}
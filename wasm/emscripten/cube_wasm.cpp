@@ -5,6 +5,36 @@
 
 using namespace emscripten;
 
+status_code c_init_solver() {
+    return static_cast<status_code>(init_solver());
+}
+
+status_code c_init_solver_async() {
+    return static_cast<status_code>(init_solver_async());
+}
+
+bool c_solver_ready() {
+    return solver_state() == TABLES_READY;
+}
+
+status_code c_set_solver_tier(int tier) {
+    return static_cast<status_code>(set_solver_tier(tier));
+}
+
+int c_get_solver_tier() {
+    return get_solver_tier();
+}
+
+status_code c_set_solver_endgame(int depth) {
+    return static_cast<status_code>(set_solver_endgame(depth));
+}
+
+std::string c_solver_tier_info(int tier) {
+    char buf[CUBE_BS] = "\0";
+    solver_tier_info(tier, buf);
+    return std::string(buf);
+}
+
 auto c_solve_ultimate(const std::string &src, const std::string &tgt, int step, bool best) -> std::pair<status_code, std::string> {
     char buf[CUBE_BS]="\0";
     int rc = solve_ultimate(src.c_str(), tgt.c_str(), buf, step, best, 1);
@@ -32,6 +62,13 @@ std::string c_permutation(const std::string &maneuver) {
 }
 
 EMSCRIPTEN_BINDINGS(cube_module) {
+    function("js_init", &c_init_solver);
+    function("js_init_async", &c_init_solver_async);
+    function("js_ready", &c_solver_ready);
+    function("js_set_tier", &c_set_solver_tier);
+    function("js_get_tier", &c_get_solver_tier);
+    function("js_tier_info", &c_solver_tier_info);
+    function("js_set_endgame", &c_set_solver_endgame);
     function("js_solve", &c_solve);
     function("js_solve_ultimate", &c_solve_ultimate);
     function("js_facecube", &c_facecube);
@@ -44,6 +81,7 @@ EMSCRIPTEN_BINDINGS(cube_module) {
         .value("Bad_src", CODE_INVALID_SRC)
         .value("Bad_tgt", CODE_INVALID_TGT)
 		.value("Unknown_err",CODE_UNKNOWN_ERROR)
+		.value("Not_ready",CODE_NOT_READY)
     ;
     value_array<std::pair<status_code,std::string>>("solve_result_t")
         .element(&std::pair<status_code, std::string>::first)
@@ -4,7 +4,15 @@ enum StatusCode {
     NOT_FOUND = 2,
     INVALID_SRC = 3,
     INVALID_TGT = 4,
-    UNKNOWN_ERR = 5
+    UNKNOWN_ERR = 5,
+    NOT_READY = 6
+}
+
+enum Tier {
+    MINIMAL = 0,
+    STANDARD = 1,
+    LARGE = 2,
+    EXACT = 3
 }
 
 type SolveResult = {
@@ -13,6 +21,13 @@ type SolveResult = {
 }
 
 interface CubeAPI {
+    init: () => StatusCode;
+    init_async: () => StatusCode;
+    ready: () => boolean;
+    set_tier: (tier: Tier) => StatusCode;
+    get_tier: () => Tier;
+    tier_info: (tier: Tier) => string;
+    set_endgame: (depth: number) => StatusCode;
     solvable: (src: string) => boolean;
     get_facecube: (maneuver: string, cube?: string) => string;
     get_permutation: (maneuver: string) => string;
@@ -27,6 +42,34 @@ async function createAPI(
 ): Promise<CubeAPI> {
     const module_ = await initModule();
 
+    function init():StatusCode {
+        return module_.js_init().value;     // object -> integer
+    }
+
+    function init_async():StatusCode {
+        return module_.js_init_async().value;
+    }
+
+    function ready():boolean {
+        return module_.js_ready();
+    }
+
+    function set_tier(tier:Tier):StatusCode {
+        return module_.js_set_tier(tier).value;
+    }
+
+    function get_tier():Tier {
+        return module_.js_get_tier();
+    }
+
+    function tier_info(tier:Tier):string {
+        return module_.js_tier_info(tier);
+    }
+
+    function set_endgame(depth:number):StatusCode {
+        return module_.js_set_endgame(depth).value;
+    }
+
     function solvable(src:string):boolean {
         return module_.js_solvable(src);
     }
@@ -56,6 +99,13 @@ async function createAPI(
     }
 
     return {
+        init,
+        init_async,
+        ready,
+        set_tier,
+        get_tier,
+        tier_info,
+        set_endgame,
         solvable,
         get_facecube,
         get_permutation,
@@ -64,5 +114,5 @@ async function createAPI(
     };
 }
 
-export { createAPI, StatusCode, SolveResult, CubeID };
+export { createAPI, StatusCode, Tier, SolveResult, CubeID };
 export type { CubeAPI };
\ No newline at end of file